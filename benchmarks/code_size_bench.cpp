@@ -0,0 +1,270 @@
+// 1000个不同日志语句的代码体积和执行开销
+// 每条语句的格式串和参数类型组合都不同（10种类型取3个），各自实例化一份日志模板。
+// 默认构建使用当前的Logger：模板只打包参数，格式化和分发在共用的noinline vlog里。
+// cpp_log_code_size_baseline_bench定义CPP_LOG_BENCH_BASELINE，改用BaselineLogger，
+// 它照搬类型擦除之前的Logger::log：每个调用点实例化的模板里直接调用std::format并逐个写入sink。
+// 对比两个可执行文件的size输出得到代码体积差；Linux上用perf_event_open统计执行全部语句时的
+// 一级指令缓存未命中次数，没有硬件计数器（虚拟机、容器或perf_event_paranoid限制）时输出n/a
+// 用法：cpp_log_code_size_bench [轮数]
+#include <cpp_log/log.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// 只格式化到复用的缓冲区，不做任何I/O
+class NullSink : public cpp_log::LogSink {
+public:
+    NullSink() {
+        formatter_ = cpp_log::shared_default_formatter();
+    }
+
+    void write(const cpp_log::LogContext& context) override {
+        bytes_ += formatter_->format(context).size();
+    }
+
+    void write_record(const cpp_log::RecordPtr& record) override {
+        if (!should_log(record->context().level)) {
+            return;
+        }
+        scratch_.clear();
+        bytes_ += record->text(*formatter_, scratch_).size();
+    }
+
+private:
+    std::string scratch_;
+    size_t bytes_ = 0;
+};
+
+// 类型擦除之前的Logger::log，格式化和分发都在每个参数组合的实例里
+class BaselineLogger {
+public:
+    void add_sink(std::shared_ptr<cpp_log::LogSink> sink) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sinks_.push_back(std::move(sink));
+    }
+
+    void set_level(cpp_log::Level level) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        min_level_ = level;
+    }
+
+    bool should_log(cpp_log::Level level) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return level >= min_level_;
+    }
+
+    template<typename... Args>
+    void log(cpp_log::Level level,
+             const std::source_location& location,
+             std::format_string<Args...> fmt,
+             Args&&... args) {
+        if (!should_log(level)) {
+            return;
+        }
+
+        cpp_log::LogContext context{
+            .level = level,
+            .timestamp = std::chrono::system_clock::now(),
+            .location = location,
+            .thread_id = std::this_thread::get_id(),
+            .message = std::format(fmt, std::forward<Args>(args)...)
+        };
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& sink : sinks_) {
+            sink->write(context);
+        }
+    }
+
+    template<typename... Args>
+    void info(const std::source_location& location,
+              std::format_string<Args...> fmt, Args&&... args) {
+        log(cpp_log::Level::Info, location, fmt, std::forward<Args>(args)...);
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<std::shared_ptr<cpp_log::LogSink>> sinks_;
+    cpp_log::Level min_level_ = cpp_log::Level::Debug;
+};
+
+#if defined(CPP_LOG_BENCH_BASELINE)
+using BenchLogger = BaselineLogger;
+#else
+using BenchLogger = cpp_log::Logger;
+#endif
+
+// 本线程在用户态的一级指令缓存未命中次数，不支持时start返回false
+class ICacheMisses {
+public:
+#if defined(__linux__)
+    ICacheMisses() {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_L1I | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    ~ICacheMisses() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    bool start() {
+        if (fd_ < 0) {
+            return false;
+        }
+        ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        return true;
+    }
+
+    std::optional<std::uint64_t> stop() {
+        if (fd_ < 0) {
+            return std::nullopt;
+        }
+        ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        std::uint64_t count = 0;
+        if (read(fd_, &count, sizeof(count)) != static_cast<ssize_t>(sizeof(count))) {
+            return std::nullopt;
+        }
+        return count;
+    }
+
+private:
+    int fd_ = -1;
+#else
+    bool start() {
+        return false;
+    }
+
+    std::optional<std::uint64_t> stop() {
+        return std::nullopt;
+    }
+#endif
+};
+
+// 10种参数类型，取值依赖i，避免被常量折叠
+#define CPP_LOG_BENCH_V0 static_cast<int>(i)
+#define CPP_LOG_BENCH_V1 0.5 * static_cast<double>(i)
+#define CPP_LOG_BENCH_V2 "text"
+#define CPP_LOG_BENCH_V3 std::string_view("view")
+#define CPP_LOG_BENCH_V4 static_cast<long long>(i)
+#define CPP_LOG_BENCH_V5 static_cast<unsigned>(i)
+#define CPP_LOG_BENCH_V6 'c'
+#define CPP_LOG_BENCH_V7 (i & 1) != 0
+#define CPP_LOG_BENCH_V8 static_cast<float>(i)
+#define CPP_LOG_BENCH_V9 static_cast<short>(i)
+
+#define CPP_LOG_BENCH_STMT(a, b, c)                                                      \
+    logger.info(std::source_location::current(), "statement " #a #b #c " {} {} {}",     \
+                CPP_LOG_BENCH_V##a, CPP_LOG_BENCH_V##b, CPP_LOG_BENCH_V##c);
+#define CPP_LOG_BENCH_ROW(a, b)                                                          \
+    CPP_LOG_BENCH_STMT(a, b, 0) CPP_LOG_BENCH_STMT(a, b, 1) CPP_LOG_BENCH_STMT(a, b, 2)  \
+    CPP_LOG_BENCH_STMT(a, b, 3) CPP_LOG_BENCH_STMT(a, b, 4) CPP_LOG_BENCH_STMT(a, b, 5)  \
+    CPP_LOG_BENCH_STMT(a, b, 6) CPP_LOG_BENCH_STMT(a, b, 7) CPP_LOG_BENCH_STMT(a, b, 8)  \
+    CPP_LOG_BENCH_STMT(a, b, 9)
+#define CPP_LOG_BENCH_PLANE(a)                                                           \
+    void plane_##a(BenchLogger& logger, size_t i) {                                      \
+        CPP_LOG_BENCH_ROW(a, 0) CPP_LOG_BENCH_ROW(a, 1) CPP_LOG_BENCH_ROW(a, 2)          \
+        CPP_LOG_BENCH_ROW(a, 3) CPP_LOG_BENCH_ROW(a, 4) CPP_LOG_BENCH_ROW(a, 5)          \
+        CPP_LOG_BENCH_ROW(a, 6) CPP_LOG_BENCH_ROW(a, 7) CPP_LOG_BENCH_ROW(a, 8)          \
+        CPP_LOG_BENCH_ROW(a, 9)                                                          \
+    }
+
+CPP_LOG_BENCH_PLANE(0)
+CPP_LOG_BENCH_PLANE(1)
+CPP_LOG_BENCH_PLANE(2)
+CPP_LOG_BENCH_PLANE(3)
+CPP_LOG_BENCH_PLANE(4)
+CPP_LOG_BENCH_PLANE(5)
+CPP_LOG_BENCH_PLANE(6)
+CPP_LOG_BENCH_PLANE(7)
+CPP_LOG_BENCH_PLANE(8)
+CPP_LOG_BENCH_PLANE(9)
+
+// 一轮依次执行全部1000条语句
+void run_all(BenchLogger& logger, size_t i) {
+    plane_0(logger, i);
+    plane_1(logger, i);
+    plane_2(logger, i);
+    plane_3(logger, i);
+    plane_4(logger, i);
+    plane_5(logger, i);
+    plane_6(logger, i);
+    plane_7(logger, i);
+    plane_8(logger, i);
+    plane_9(logger, i);
+}
+
+struct Result {
+    double ns_per_record;
+    std::optional<std::uint64_t> icache_misses;  // 整个测量期间的总数
+};
+
+Result measure(BenchLogger& logger, size_t rounds) {
+    ICacheMisses misses;
+    misses.start();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; ++i) {
+        run_all(logger, i);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    auto count = misses.stop();
+    return {std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(rounds * 1000), count};
+}
+
+void print(const char* name, const Result& result, size_t rounds) {
+    if (result.icache_misses) {
+        std::printf("%-24s %9.1f ns %12.2f L1I misses/statement\n", name, result.ns_per_record,
+                    static_cast<double>(*result.icache_misses) / static_cast<double>(rounds * 1000));
+    } else {
+        std::printf("%-24s %9.1f ns %12s L1I misses/statement\n", name, result.ns_per_record, "n/a");
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t rounds = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000;
+
+    BenchLogger logger;
+    logger.add_sink(std::make_shared<NullSink>());
+    // 先跑一轮预热缓存池和分配器
+    measure(logger, rounds / 10 + 1);
+
+    logger.set_level(cpp_log::Level::Debug);
+    auto enabled = measure(logger, rounds);
+    // 等级过滤掉的调用只剩下过滤本身的开销
+    logger.set_level(cpp_log::Level::Error);
+    auto filtered = measure(logger, rounds);
+
+#if defined(CPP_LOG_BENCH_BASELINE)
+    std::printf("baseline: std::format at every call site\n");
+#else
+    std::printf("type-erased: shared vlog\n");
+#endif
+    print("1000 statements", enabled, rounds);
+    print("  filtered out", filtered, rounds);
+    return 0;
+}
@@ -0,0 +1,75 @@
+// JsonFormatter与DefaultFormatter的单条格式化开销，以及纯ASCII文本的转义吞吐
+// CMake同时以CPP_LOG_NO_SSE2编译cpp_log_json_formatter_scalar_bench，对比逐字节查表的实现
+// 用法：cpp_log_json_formatter_bench [条数]
+#include <cpp_log/log.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+template<typename Fn>
+double seconds_for(size_t count, Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        fn(i);
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double us_per_record(cpp_log::LogFormatter& formatter, const cpp_log::LogContext& context, size_t count) {
+    std::string out;
+    size_t bytes = 0;
+    auto run = [&](size_t) {
+        out.clear();
+        formatter.format_to(context, out);
+        bytes += out.size();
+    };
+    seconds_for(count / 10 + 1, run);  // 预热时间缓存
+    double seconds = seconds_for(count, run);
+    if (bytes == 0) {
+        std::abort();
+    }
+    return seconds * 1e6 / static_cast<double>(count);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+
+    // 80字节的消息
+    std::string message(80, 'x');
+    message.replace(0, 28, "order 12345 filled at 101.5");
+    auto record = cpp_log::LogRecord::create(cpp_log::Level::Info, std::source_location::current(),
+                                             message, std::span<const cpp_log::Field>{});
+
+#ifdef CPP_LOG_JSON_SSE2
+    std::printf("escaping: SSE2\n");
+#else
+    std::printf("escaping: scalar\n");
+#endif
+
+    cpp_log::JsonFormatter json;
+    auto& plain = *cpp_log::shared_default_formatter();
+    std::printf("%-20s %8.3f us/record\n", "JsonFormatter", us_per_record(json, record->context(), count));
+    std::printf("%-20s %8.3f us/record\n", "DefaultFormatter", us_per_record(plain, record->context(), count));
+
+    // 1 MiB不需要转义的ASCII文本
+    std::string text(1 << 20, 'a');
+    for (size_t i = 0; i < text.size(); ++i) {
+        text[i] = static_cast<char>('a' + i % 26);
+    }
+    std::string out;
+    size_t rounds = 200;
+    double seconds = seconds_for(rounds, [&](size_t) {
+        out.clear();
+        cpp_log::detail::append_json_string(out, text);
+    });
+    if (out.size() != text.size() + 2) {
+        std::abort();
+    }
+    std::printf("%-20s %8.2f GB/s\n", "escape ASCII", static_cast<double>(text.size() * rounds) / seconds / 1e9);
+    return 0;
+}
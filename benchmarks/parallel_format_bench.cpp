@@ -0,0 +1,61 @@
+// ParallelFormatSink的吞吐：4个生产者线程写入，分别用1、2、4个格式化线程，
+// 输出到/dev/null的文本文件sink和JSON文件sink，计时到sink析构（全部写出）为止。
+// 格式化线程数超过可用核心数时不会再有提升
+// 用法：cpp_log_parallel_format_bench [总条数]
+#include <cpp_log/log.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int producers = 4;
+
+double lines_per_second(size_t formatter_threads, size_t total) {
+    auto text = std::make_shared<cpp_log::FileSink>("/dev/null");
+    auto json = std::make_shared<cpp_log::FileSink>("/dev/null");
+    json->set_formatter(std::make_shared<cpp_log::JsonFormatter>());
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        cpp_log::ParallelFormatOptions options;
+        options.formatter_threads = formatter_threads;
+        auto sink = std::make_shared<cpp_log::ParallelFormatSink>(
+            std::vector<std::shared_ptr<cpp_log::LogSink>>{text, json}, options);
+        cpp_log::Logger logger;
+        logger.add_sink(sink);
+
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&logger, p, total] {
+                for (size_t i = 0; i < total / producers; ++i) {
+                    logger.info(std::source_location::current(), "producer {} order {} filled at {}", p, i, 101.5);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        // 析构时写完全部批次
+        logger.clear_sinks();
+        sink.reset();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(total / producers * producers) / seconds;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t total = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    std::printf("%u hardware threads, %d producers, %zu lines\n",
+                std::thread::hardware_concurrency(), producers, total);
+    for (size_t threads : {1, 2, 4}) {
+        std::printf("%zu formatter threads: %10.0f lines/s\n", threads, lines_per_second(threads, total));
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+// StaticLogger与Logger的单条日志开销对比
+// 两者同步写入同样的sink，差别只在分发方式：Logger经过vlog和sink的虚函数，
+// StaticLogger直接调用具体类型。NullSink只格式化不输出，用来单独观察分发和格式化的开销
+// 用法：cpp_log_static_logger_bench [条数]
+#include <cpp_log/log.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+namespace {
+
+template<typename Fn>
+double ns_per_record(size_t count, Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        fn(i);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(count);
+}
+
+// 只格式化到复用的缓冲区，不做任何I/O
+class NullSink : public cpp_log::LogSink {
+public:
+    NullSink() {
+        formatter_ = cpp_log::shared_default_formatter();
+    }
+
+    void write(const cpp_log::LogContext& context) override {
+        bytes_ += formatter_->format(context).size();
+    }
+
+    void write_record(const cpp_log::RecordPtr& record) override {
+        if (!should_log(record->context().level)) {
+            return;
+        }
+        scratch_.clear();
+        bytes_ += record->text(*formatter_, scratch_).size();
+    }
+
+private:
+    std::string scratch_;
+    size_t bytes_ = 0;
+};
+
+template<typename DynamicLogger, typename StaticLogger>
+void compare(const char* name, size_t count, DynamicLogger& logger, StaticLogger& static_logger) {
+    auto run_dynamic = [&](size_t i) {
+        logger.info(std::source_location::current(), "order {} filled at {}", i, 1.5);
+    };
+    auto run_static = [&](size_t i) {
+        static_logger.info(std::source_location::current(), "order {} filled at {}", i, 1.5);
+    };
+    // 先各跑一轮预热缓存池和分配器
+    ns_per_record(count / 10 + 1, run_dynamic);
+    ns_per_record(count / 10 + 1, run_static);
+
+    logger.set_level(cpp_log::Level::Debug);
+    static_logger.set_level(cpp_log::Level::Debug);
+    double dynamic_ns = ns_per_record(count, run_dynamic);
+    double static_ns = ns_per_record(count, run_static);
+
+    // 等级过滤掉的调用只剩下过滤本身的开销
+    logger.set_level(cpp_log::Level::Error);
+    static_logger.set_level(cpp_log::Level::Error);
+    double dynamic_filtered_ns = ns_per_record(count, run_dynamic);
+    double static_filtered_ns = ns_per_record(count, run_static);
+
+    std::printf("%-24s %9.1f ns %9.1f ns\n", name, dynamic_ns, static_ns);
+    std::printf("%-24s %9.1f ns %9.1f ns\n", "  filtered out", dynamic_filtered_ns, static_filtered_ns);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+
+    std::printf("%-24s %12s %12s\n", "", "Logger", "StaticLogger");
+
+    {
+        cpp_log::Logger logger;
+        logger.add_sink(std::make_shared<NullSink>());
+        cpp_log::StaticLogger<NullSink> static_logger;
+        compare("NullSink", count, logger, static_logger);
+    }
+    {
+        cpp_log::Logger logger;
+        logger.add_sink(std::make_shared<cpp_log::FileSink>("/dev/null"));
+        cpp_log::StaticLogger<cpp_log::FileSink> static_logger{cpp_log::FileSink{"/dev/null"}};
+        compare("FileSink(/dev/null)", count, logger, static_logger);
+    }
+    return 0;
+}
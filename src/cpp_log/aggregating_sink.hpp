@@ -0,0 +1,375 @@
+#pragma once
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <source_location>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "cpp_log/backend.hpp"
+#include "cpp_log/fields.hpp"
+#include "cpp_log/level.hpp"
+#include "cpp_log/record.hpp"
+#include "cpp_log/sink.hpp"
+
+namespace cpp_log {
+
+namespace asio = boost::asio;
+
+// 聚合输出配置
+struct AggregatingOptions {
+    std::chrono::milliseconds interval{60000};  // 汇总周期
+    Level passthrough_level = Level::Warning;   // 达到该等级的日志除了计数还照常转发给输出目标
+    size_t max_callsites = 1024;  // 调用点表的容量（向上取2的幂），表满后新的调用点只计入overflow
+    std::string metrics_file;     // 非空时每个周期用Prometheus文本格式重写该文件
+};
+
+// 把日志聚合成计数的输出
+// 按等级和调用点（文件、行号、等级）统计日志条数，每个周期向输出目标写一条汇总日志
+// （消息为"log summary"，字段为周期内各等级和各调用点"file:line"的条数），
+// 和/或把累计计数写入指标文件，代替逐条输出。passthrough_level及以上的日志仍然逐条转发，
+// 不丢失告警信号。写入方的计数只用原子操作：调用点表是开放寻址的固定容量哈希表，
+// 新调用点用CAS占用槽位，占用方写完调用点之前同一调用点的其他日志计入overflow，不等待；
+// 汇总在后台协程中进行
+class AggregatingSink : public LogSink {
+public:
+    AggregatingSink(std::shared_ptr<LogSink> output, AggregatingOptions options = {})
+        : AggregatingSink(std::move(output), std::move(options), LogBackend::instance().get_io_context()) {}
+
+    AggregatingSink(std::shared_ptr<LogSink> output,
+                    AggregatingOptions options,
+                    asio::io_context& ioc)
+        : state_(std::make_shared<State>(std::move(output), std::move(options), ioc)) {
+        if (!state_->output && state_->options.metrics_file.empty()) {
+            throw std::invalid_argument("AggregatingSink requires an output sink or a metrics file");
+        }
+        if (state_->options.interval <= std::chrono::milliseconds::zero()) {
+            throw std::invalid_argument("AggregatingSink interval must be positive");
+        }
+        asio::co_spawn(state_->strand, report_loop(state_), asio::detached);
+    }
+
+    // 输出最后一个不完整周期的计数后释放输出目标，目标在调用线程上析构，不会留给后台协程
+    // 同时取消后台正在等待的定时器，汇总协程随即退出并释放状态，不会等到下一个周期
+    ~AggregatingSink() override {
+        state_->running = false;
+        asio::post(state_->strand, [state = state_]() {
+            state->timer.cancel();
+        });
+        std::shared_ptr<LogSink> output;
+        {
+            std::lock_guard<std::mutex> lock(state_->report_mutex);
+            report_locked(*state_);
+            state_->closed = true;
+            output = std::move(state_->output);
+        }
+    }
+
+    void write(const LogContext& context) override {
+        if (!should_log(context.level)) {
+            return;
+        }
+        count(context);
+        if (forwards(context.level)) {
+            std::lock_guard<std::mutex> lock(state_->output_mutex);
+            state_->output->write(context);
+        }
+    }
+
+    void write_record(const RecordPtr& record) override {
+        const auto& context = record->context();
+        if (!should_log(context.level)) {
+            return;
+        }
+        count(context);
+        if (forwards(context.level)) {
+            std::lock_guard<std::mutex> lock(state_->output_mutex);
+            state_->output->write_record(record);
+        }
+    }
+
+    void flush() override {
+        if (state_->output) {
+            std::lock_guard<std::mutex> lock(state_->output_mutex);
+            state_->output->flush();
+        }
+    }
+
+    bool healthy() const override {
+        if (!state_->metrics_ok.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        return !state_->output || state_->output->healthy();
+    }
+
+    // 只有转发的日志会进入输出目标
+    double pressure() const override {
+        return state_->output ? state_->output->pressure() : 0.0;
+    }
+
+    bool asynchronous() const override {
+        return state_->output && state_->output->asynchronous();
+    }
+
+    // 立即输出当前周期的汇总，不等待周期结束
+    void report_now() {
+        report(*state_);
+    }
+
+private:
+    static constexpr size_t level_count = static_cast<size_t>(Level::Fatal) + 1;
+
+    // 调用点表的槽位，key为0表示空闲；占用后写入调用点再置ready
+    struct Slot {
+        std::atomic<std::uint64_t> key{0};
+        std::atomic<bool> ready{false};
+        const char* file = nullptr;
+        std::uint32_t line = 0;
+        Level level = Level::Debug;
+        std::atomic<std::uint64_t> count{0};
+    };
+
+    // 汇总时按文件名文本合并：同一个调用点在不同翻译单元中的文件名指针可能不同
+    using CallsiteKey = std::tuple<std::string, std::uint32_t, Level>;
+
+    // 与后台汇总协程共享的状态，sink析构后由协程持有直到退出
+    // 析构时在report_mutex下取走output并取消定时器，协程随即退出
+    struct State {
+        State(std::shared_ptr<LogSink> output_, AggregatingOptions options_, asio::io_context& ioc)
+            : output(std::move(output_))
+            , options(std::move(options_))
+            , slots(std::bit_ceil(std::max<size_t>(options.max_callsites, 1)))
+            , strand(asio::make_strand(ioc))
+            , timer(strand) {}
+
+        std::shared_ptr<LogSink> output;
+        AggregatingOptions options;
+        std::vector<Slot> slots;
+        std::array<std::atomic<std::uint64_t>, level_count> levels{};
+        std::atomic<std::uint64_t> overflow{0};
+        asio::strand<asio::io_context::executor_type> strand;
+        asio::steady_timer timer;  // 汇总协程等待的定时器，只在strand上访问
+        std::atomic<bool> running{true};
+        std::atomic<bool> metrics_ok{true};
+        std::mutex output_mutex;  // 转发的日志与汇总日志可能来自不同线程
+
+        // 以下只在持有report_mutex时访问
+        std::mutex report_mutex;
+        std::chrono::steady_clock::time_point period_start = std::chrono::steady_clock::now();
+        std::array<std::uint64_t, level_count> level_totals{};
+        std::map<CallsiteKey, std::uint64_t> callsite_totals;
+        std::uint64_t overflow_total = 0;
+        bool closed = false;  // sink已析构，不再汇总
+    };
+
+    bool forwards(Level level) const {
+        return state_->output && level >= state_->options.passthrough_level;
+    }
+
+    void count(const LogContext& context) {
+        auto& state = *state_;
+        state.levels[static_cast<size_t>(context.level)].fetch_add(1, std::memory_order_relaxed);
+        if (auto* slot = find_slot(context.location.file_name(), context.location.line(), context.level)) {
+            slot->count.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            state.overflow.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // 查找调用点对应的槽位，不存在时占用一个空闲槽位
+    // 表满或者槽位正被其他线程占用、调用点还没写完时返回nullptr，不自旋等待
+    Slot* find_slot(const char* file, std::uint32_t line, Level level) {
+        auto& slots = state_->slots;
+        std::uint64_t key = (std::hash<const void*>{}(file) ^
+                             (static_cast<std::uint64_t>(line) * 0x9E3779B97F4A7C15ull) ^
+                             (static_cast<std::uint64_t>(level) << 56)) | 1;
+        size_t mask = slots.size() - 1;
+        size_t index = static_cast<size_t>(key * 0xFF51AFD7ED558CCDull >> 32) & mask;
+        for (size_t probe = 0; probe < slots.size(); ++probe, index = (index + 1) & mask) {
+            auto& slot = slots[index];
+            auto current = slot.key.load(std::memory_order_acquire);
+            if (current == 0) {
+                if (slot.key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+                    slot.file = file;
+                    slot.line = line;
+                    slot.level = level;
+                    slot.ready.store(true, std::memory_order_release);
+                    return &slot;
+                }
+                // 被其他线程抢先占用，current为对方的key
+            }
+            if (current == key) {
+                // 对方刚占用还没写完调用点时不等待：占用方可能在两步之间被挂起，
+                // 这条日志只计入overflow，等级计数不受影响
+                if (!slot.ready.load(std::memory_order_acquire)) {
+                    return nullptr;
+                }
+                if (slot.file == file && slot.line == line && slot.level == level) {
+                    return &slot;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    static void report(State& state) {
+        std::lock_guard<std::mutex> lock(state.report_mutex);
+        if (!state.closed) {
+            report_locked(state);
+        }
+    }
+
+    static void report_locked(State& state) {
+        auto now = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - state.period_start);
+        state.period_start = now;
+
+        std::array<std::uint64_t, level_count> levels{};
+        std::uint64_t total = 0;
+        for (size_t i = 0; i < level_count; ++i) {
+            levels[i] = state.levels[i].exchange(0, std::memory_order_relaxed);
+            state.level_totals[i] += levels[i];
+            total += levels[i];
+        }
+        auto overflow = state.overflow.exchange(0, std::memory_order_relaxed);
+        state.overflow_total += overflow;
+
+        std::map<CallsiteKey, std::uint64_t> callsites;
+        for (auto& slot : state.slots) {
+            if (!slot.ready.load(std::memory_order_acquire)) {
+                continue;
+            }
+            if (auto count = slot.count.exchange(0, std::memory_order_relaxed)) {
+                CallsiteKey key{slot.file, slot.line, slot.level};
+                callsites[key] += count;
+                state.callsite_totals[key] += count;
+            }
+        }
+
+        if (state.output && total > 0) {
+            write_summary(state, elapsed, levels, total, overflow, callsites);
+        }
+        if (!state.options.metrics_file.empty()) {
+            write_metrics_file(state);
+        }
+    }
+
+    static void write_summary(State& state,
+                              std::chrono::milliseconds elapsed,
+                              const std::array<std::uint64_t, level_count>& levels,
+                              std::uint64_t total,
+                              std::uint64_t overflow,
+                              const std::map<CallsiteKey, std::uint64_t>& callsites) {
+        // 调用点按条数从多到少排列，字段的key引用names中的文本
+        std::vector<std::pair<std::string, std::uint64_t>> names;
+        names.reserve(callsites.size());
+        for (const auto& [key, count] : callsites) {
+            names.emplace_back(std::format("{}:{}", std::get<0>(key), std::get<1>(key)), count);
+        }
+        std::stable_sort(names.begin(), names.end(),
+                         [](const auto& a, const auto& b) { return a.second > b.second; });
+
+        std::vector<Field> fields;
+        fields.reserve(3 + level_count + names.size());
+        fields.push_back(kv("interval_ms", elapsed.count()));
+        fields.push_back(kv("total", total));
+        for (size_t i = 0; i < level_count; ++i) {
+            if (levels[i] > 0) {
+                fields.push_back(kv(get_level_string(static_cast<Level>(i)), levels[i]));
+            }
+        }
+        if (overflow > 0) {
+            fields.push_back(kv("overflow", overflow));
+        }
+        for (const auto& [name, count] : names) {
+            fields.push_back(kv(name, count));
+        }
+
+        auto record = LogRecord::create(Level::Info, std::source_location::current(), "log summary", fields);
+        std::lock_guard<std::mutex> lock(state.output_mutex);
+        state.output->write_record(record);
+        state.output->flush();
+    }
+
+    // 写入临时文件后改名，读取方（如node_exporter的textfile收集器）不会读到写了一半的文件
+    static void write_metrics_file(State& state) {
+        const auto& path = state.options.metrics_file;
+        std::string tmp = path + ".tmp";
+        std::string text;
+        text += "# TYPE cpp_log_records_total counter\n";
+        for (size_t i = 0; i < level_count; ++i) {
+            std::format_to(std::back_inserter(text), "cpp_log_records_total{{level=\"{}\"}} {}\n",
+                           get_level_string(static_cast<Level>(i)), state.level_totals[i]);
+        }
+        text += "# TYPE cpp_log_callsite_records_total counter\n";
+        for (const auto& [key, count] : state.callsite_totals) {
+            text += "cpp_log_callsite_records_total{file=\"";
+            append_label_value(text, std::get<0>(key));
+            std::format_to(std::back_inserter(text), "\",line=\"{}\",level=\"{}\"}} {}\n",
+                           std::get<1>(key), get_level_string(std::get<2>(key)), count);
+        }
+        text += "# TYPE cpp_log_callsite_overflow_total counter\n";
+        std::format_to(std::back_inserter(text), "cpp_log_callsite_overflow_total {}\n", state.overflow_total);
+
+        bool ok = false;
+        {
+            std::ofstream file(tmp, std::ios::out | std::ios::trunc);
+            file.write(text.data(), static_cast<std::streamsize>(text.size()));
+            ok = file.good();
+        }
+        std::error_code ec;
+        if (ok) {
+            std::filesystem::rename(tmp, path, ec);
+        }
+        state.metrics_ok.store(ok && !ec, std::memory_order_relaxed);
+    }
+
+    // Prometheus标签值中的反斜杠、引号和换行需要转义
+    static void append_label_value(std::string& out, std::string_view value) {
+        for (char c : value) {
+            switch (c) {
+                case '\\': out += "\\\\"; break;
+                case '"': out += "\\\""; break;
+                case '\n': out += "\\n"; break;
+                default: out += c; break;
+            }
+        }
+    }
+
+    static asio::awaitable<void> report_loop(std::shared_ptr<State> state) {
+        while (state->running) {
+            state->timer.expires_after(state->options.interval);
+            boost::system::error_code ec;
+            co_await state->timer.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+            if (ec == asio::error::operation_aborted || !state->running) {
+                break;
+            }
+            report(*state);
+        }
+    }
+
+    std::shared_ptr<State> state_;
+};
+
+} // namespace cpp_log
@@ -4,99 +4,1155 @@
 #include <boost/asio/co_spawn.hpp>
 #include <boost/asio/detached.hpp>
 #include <boost/asio/io_context.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/asio/strand.hpp>
 #include <queue>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <algorithm>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <future>
+#include <chrono>
+#include <thread>
+#include <span>
+#include <string>
+#include <vector>
+#include "cpp_log/backend.hpp"
 #include "cpp_log/sink.hpp"
 #include "cpp_log/color.hpp"
+#include "cpp_log/metrics.hpp"
+#include "cpp_log/probes.hpp"
+#include "cpp_log/reorder_buffer.hpp"
 
 namespace cpp_log {
 
 namespace asio = boost::asio;
 
+// 队列已满时的处理方式
+enum class OverflowPolicy {
+    DropNewest,  // 丢弃新提交的日志
+    DropOldest,  // 丢弃队列中最早的日志
+    Block        // 生产者等待队列腾出空间；在sink自己的io_context线程上无法等待，按DropNewest处理
+};
+
+// 普通通道的刷新时机，高优先级通道总是每条都刷新
+enum class FlushPolicy {
+    EveryBatch,  // 每批写完刷新一次
+    EveryRecord  // 每条写完都刷新
+};
+
+// 后台处理循环没有日志可写时的等待方式
+enum class WaitStrategy {
+    Spin,       // 一直重新投递自己，延迟最低，始终占满一个核心，只适合有独占核心的主机
+    SpinYield,  // 空转一段时间后每轮让出CPU
+    Block       // 空转一段时间后在定时器上休眠，有新日志或超时才唤醒（默认）
+};
+
+// 自适应批量配置
+struct AdaptiveBatchOptions {
+    std::string name;                  // 指标名前缀，为空时为"async_sink.<序号>"，每个sink各不相同
+    size_t min_batch = 16;             // 批量下限
+    size_t max_batch = 4096;           // 批量上限
+    std::chrono::microseconds max_delay{2000};  // 普通通道的日志最多等待多久才写出
+};
+
 //异步日志sink基类
 class AsyncLogSink : public LogSink {
 public:
     explicit AsyncLogSink(asio::io_context& ioc)
-        : strand_(asio::make_strand(ioc)), running_(true) {
-        // 启动异步处理循环
-        asio::co_spawn(strand_, process_loop(), asio::detached);
-    }
+        : AsyncLogSink(ioc, nullptr) {}
+
+    // 挂在进程级的LogBackend上
+    AsyncLogSink()
+        : AsyncLogSink(LogBackend::instance().get_io_context()) {}
+
+    // 使用独立的执行器，处理慢的时候不会拖累其他sink
+    explicit AsyncLogSink(dedicated_executor_t)
+        : AsyncLogSink(std::make_unique<SinkExecutor>()) {}
 
     ~AsyncLogSink() {
-        running_ = false;
+        shutdown();
+        // 处理循环已经退出或脱离this，没有取走的日志随sink丢弃
+        discard_inbox();
+    }
+
+    // 设置高优先级通道的等级，达到该等级的日志不进入普通队列
+    void set_priority_level(Level level) {
+        priority_level_.store(level, std::memory_order_relaxed);
+    }
+
+    Level priority_level() const {
+        return priority_level_.load(std::memory_order_relaxed);
+    }
+
+    // 设置普通通道每批处理的最大条数，每批结束后刷新一次
+    void set_batch_size(size_t batch_size) {
+        batch_size_.store(std::max<size_t>(batch_size, 1), std::memory_order_relaxed);
     }
 
-    // 重写write方法，将日志消息和级别加入队列
+    // 启用自适应批量：根据观测到的到达速率调整普通通道的批量和刷新间隔
+    // 批量取到达速率乘以max_delay并限制在[min_batch, max_batch]之间，刷新间隔为凑够一批
+    // 预计需要的时间；队列里不足一批时等到最早的日志达到刷新间隔再写出。
+    // 到达速率低到max_delay内凑不够min_batch时不再等待，每轮立即写出。
+    // 当前的设置通过指标<name>.batch_size、<name>.flush_interval_us、<name>.arrival_rate输出，
+    // 停用自适应批量或sink析构时这些指标从注册表中移除。
+    // 启用后set_batch_size不再生效
+    void enable_adaptive_batching(AdaptiveBatchOptions options = {}) {
+        if (options.name.empty()) {
+            options.name = "async_sink." + std::to_string(sink_id_);
+        }
+        options.min_batch = std::max<size_t>(options.min_batch, 1);
+        options.max_batch = std::max(options.max_batch, options.min_batch);
+        auto state = std::make_shared<AdaptiveState>(std::move(options));
+        post_guarded([this, state]() { adaptive_ = state; });
+    }
+
+    void disable_adaptive_batching() {
+        post_guarded([this]() { adaptive_.reset(); });
+    }
+
+    // 设置普通通道的容量，队列满时按OverflowPolicy处理，0表示不限制
+    // 容量在生产者一侧预留，包括重排窗口中暂留的日志；DropOldest策略下队列满时
+    // 新日志先放在生产者一侧，sink占用的日志最多为两倍容量。
+    // 高优先级通道不受容量限制，但它的日志同样计入pending()
+    void set_capacity(size_t capacity) {
+        capacity_.store(capacity, std::memory_order_relaxed);
+    }
+
+    size_t capacity() const {
+        return capacity_.load(std::memory_order_relaxed);
+    }
+
+    void set_overflow_policy(OverflowPolicy policy) {
+        overflow_policy_.store(policy, std::memory_order_relaxed);
+    }
+
+    OverflowPolicy overflow_policy() const {
+        return overflow_policy_.load(std::memory_order_relaxed);
+    }
+
+    void set_flush_policy(FlushPolicy policy) {
+        flush_policy_.store(policy, std::memory_order_relaxed);
+    }
+
+    FlushPolicy flush_policy() const {
+        return flush_policy_.load(std::memory_order_relaxed);
+    }
+
+    // 设置后台处理循环空闲时的等待方式，timeout为Block策略单次休眠的最长时间
+    // 生产者把日志压入无锁的提交栈，不向io_context投递任务，处理循环每轮整体取走。
+    // Block策略下处理循环休眠前先置sleeping_，再挂起在定时器上，io_context上没有其他任务时
+    // 工作线程阻塞在asio的调度器中（epoll/futex）。只有看到sleeping_的生产者才投递任务取消定时器，
+    // 每次休眠最多投递一次；处理循环没有休眠时提交日志不经过调度器，没有系统调用。
+    // 共享io_context时只有所有任务都空闲，工作线程才会真正休眠
+    void set_wait_strategy(WaitStrategy strategy,
+                           std::chrono::microseconds timeout = std::chrono::milliseconds(10)) {
+        block_timeout_.store(std::max<std::int64_t>(timeout.count(), 1), std::memory_order_relaxed);
+        wait_strategy_.store(strategy, std::memory_order_relaxed);
+    }
+
+    WaitStrategy wait_strategy() const {
+        return wait_strategy_.load(std::memory_order_relaxed);
+    }
+
+    // 设置普通通道的重排窗口，0表示不重排（默认）
+    // 启用后普通通道的日志先在缓冲区中停留window，按各生产者线程做k路归并，
+    // 以(时间戳, 序号)的顺序写出；高优先级通道不参与重排
+    void set_reorder_window(std::chrono::nanoseconds window) {
+        reorder_window_.store(std::max<std::int64_t>(window.count(), 0), std::memory_order_relaxed);
+    }
+
+    std::chrono::nanoseconds reorder_window() const {
+        return std::chrono::nanoseconds(reorder_window_.load(std::memory_order_relaxed));
+    }
+
+    // 超过重排窗口才到达、没能按顺序写出的日志条数
+    std::uint64_t late_records() const {
+        return late_.load(std::memory_order_relaxed);
+    }
+
+    // 已提交但尚未写出的日志条数
+    size_t pending() const {
+        return pending_.load(std::memory_order_relaxed);
+    }
+
+    // 普通通道的填充比例，没有设置容量时总是0
+    double pressure() const override {
+        size_t capacity = capacity_.load(std::memory_order_relaxed);
+        if (capacity == 0) {
+            return 0.0;
+        }
+        return std::min(1.0, static_cast<double>(pending()) / static_cast<double>(capacity));
+    }
+
+    bool asynchronous() const override {
+        return true;
+    }
+
+    // 因队列已满而丢弃的日志条数
+    std::uint64_t dropped() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    // 最早一条尚未写出的日志在队列中已经等待的时间，没有积压时为0
+    // 从提交给sink时开始计算，使用steady_clock，不受系统时钟调整影响
+    std::chrono::nanoseconds lag() const {
+        auto oldest = oldest_pending_.load(std::memory_order_relaxed);
+        if (pending() == 0 || oldest == 0) {
+            return std::chrono::nanoseconds::zero();
+        }
+        auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        return std::chrono::nanoseconds(std::max<std::int64_t>(now - oldest, 0));
+    }
+
+    // 复制一份日志记录后加入队列
     void write(const LogContext& context) override {
         if (!should_log(context.level)) {
             return;
         }
+        write_record(LogRecord::create(context));
+    }
+
+    // 只增加记录的引用计数后加入队列，格式化推迟到后台执行
+    void write_record(const RecordPtr& record) override {
+        if (!should_log(record->context().level)) {
+            return;
+        }
+
+        bool urgent = record->context().level >= priority_level();
+        if (urgent) {
+            pending_.fetch_add(1, std::memory_order_relaxed);
+        } else if (!reserve_slot()) {
+            if (overflow_policy() == OverflowPolicy::DropOldest) {
+                displace(record);
+            } else {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+            }
+            return;
+        }
+
+        push_inbox(new InboxNode{record, urgent,
+                                 detail::fork_generation().load(std::memory_order_relaxed),
+                                 std::chrono::steady_clock::now()});
+    }
+
+    // 已经用本sink的格式化器格式化好的日志：文本放入记录的缓存后照常入队，后台写出时不再格式化
+    void write_formatted_batch(std::span<const FormattedRecord> records) override {
+        for (const auto& record : records) {
+            if (!should_log(record.context().level)) {
+                continue;
+            }
+            if (formatter_) {
+                record.record->cache_text(*formatter_, record.text);
+            }
+            write_record(record.record);
+        }
+    }
 
-        std::string formatted = formatter_->format(context);
-        asio::post(strand_, [this, formatted = std::move(formatted), level = context.level]() {
-            message_queue_.push({std::move(formatted), level});
+    // 写出调用之前提交的全部日志（包括重排窗口和自适应批量暂留的日志），刷新底层输出并等待完成
+    // 在sink所在io_context的线程上调用时无法等待，只请求处理循环尽快写出；
+    // 与shutdown一样，io_context已停止或者长时间没有任何进展时放弃等待
+    void flush() override {
+        auto& ioc = static_cast<asio::io_context&>(strand_.context());
+        if (shutdown_called_ || ioc.stopped()) {
+            return;
+        }
+        // 任务没有执行就被丢弃时promise随之析构，等待也会结束
+        auto done = std::make_shared<std::promise<void>>();
+        auto done_future = done->get_future();
+        post_guarded([this, done]() {
+            flush_waiters_.push_back(done);
+            if (idle_timer_) {
+                idle_timer_->cancel();
+            }
         });
+        if (!ioc.get_executor().running_in_this_thread()) {
+            wait_for_strand(ioc, done_future);
+        }
     }
 
 protected:
     // 实际的写入操作，由派生类实现
     virtual asio::awaitable<void> do_write(const std::string& message, Level level) = 0;
 
+    // 写出一条日志记录，默认在后台格式化后交给do_write
+    virtual asio::awaitable<void> do_write_record(const RecordPtr& record) {
+        std::string scratch;
+        co_await do_write(std::string(record->text(*formatter_, scratch)), record->context().level);
+    }
+
+    // 写出一批日志记录，默认逐条调用do_write_record；AsyncConsoleSink和AsyncFileSink整批拼接后一次写出
+    virtual asio::awaitable<void> do_write_batch(std::span<const RecordPtr> records) {
+        for (const auto& record : records) {
+            co_await do_write_record(record);
+        }
+    }
+
+    // 刷新底层输出，默认实现为空
+    virtual asio::awaitable<void> do_flush() {
+        co_return;
+    }
+
+    // 在strand上执行fn，与写出日志串行；sink析构之后不再执行
+    template<typename Fn>
+    void run_on_strand(Fn&& fn) {
+        post_guarded(std::forward<Fn>(fn));
+    }
+
+    // 停止处理循环，并等待已经提交的日志全部写完
+    // 派生类必须在自己的析构函数中调用，保证do_write不会在派生类成员析构之后执行
+    // io_context已停止、在其工作线程中析构或者长时间没有进展时无法等待，此时让处理循环脱离this，
+    // 未写完的日志会被丢弃；返回之后处理循环和投递到strand上的任务都不会再访问this
+    void shutdown() {
+        if (shutdown_called_.exchange(true)) {
+            return;
+        }
+
+        auto& ioc = static_cast<asio::io_context&>(strand_.context());
+        if (ioc.stopped() || ioc.get_executor().running_in_this_thread()) {
+            running_ = false;
+            detach();
+            return;
+        }
+
+        // 先等待之前投递的任务（例如移入displaced_的日志）全部执行，再通知处理循环退出
+        // 放弃等待时这个任务可能晚于本函数返回才执行，promise由任务自己持有
+        auto posted = std::make_shared<std::promise<void>>();
+        auto posted_future = posted->get_future();
+        asio::post(strand_, [posted]() { posted->set_value(); });
+        if (!wait_for_strand(ioc, posted_future)) {
+            running_ = false;
+            detach();
+            return;
+        }
+
+        running_ = false;
+        post_guarded([this]() {
+            if (idle_timer_) {
+                idle_timer_->cancel();
+            }
+        });
+        if (!wait_for_strand(ioc, loop_done_future_)) {
+            detach();
+        }
+    }
+
 private:
-    // 异步处理循环
-    asio::awaitable<void> process_loop() {
-        while (running_) {
+    AsyncLogSink(std::unique_ptr<SinkExecutor>&& executor)
+        : AsyncLogSink(executor->get_io_context(), std::move(executor)) {}
+
+    AsyncLogSink(asio::io_context& ioc, std::unique_ptr<SinkExecutor>&& executor)
+        : executor_(std::move(executor)), strand_(asio::make_strand(ioc)), running_(true) {
+        formatter_ = shared_default_formatter();
+        // 启动异步处理循环
+        asio::co_spawn(strand_, process_loop(guard_), asio::detached);
+    }
+
+    // 处理循环和投递到strand上的任务共用，sink析构时无法等待处理循环退出的情况下由它们判断能否访问this
+    // mutex只保护这两个标志，不在co_await期间持有：处理循环在一轮中挂起时strand可以照常执行其他任务
+    struct LoopGuard {
+        // 开始一轮，已经脱离this时返回false
+        bool enter() {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (detached) {
+                return false;
+            }
+            busy = true;
+            return true;
+        }
+
+        // 结束一轮，detach_now为true时同时脱离this
+        void leave(bool detach_now = false) {
+            std::lock_guard<std::mutex> lock(mutex);
+            busy = false;
+            detached = detached || detach_now;
+            idle.notify_all();
+        }
+
+        std::mutex mutex;
+        std::condition_variable idle;  // 一轮结束时通知detach
+        bool detached = false;
+        bool busy = false;  // 处理循环正在执行一轮（可能挂起在do_write等调用中）
+    };
+
+    // 投递到strand上执行fn，处理循环已经脱离this时不再执行
+    // fn是同步的，执行期间持有mutex，detach返回之后不会再有任务访问this
+    template<typename Fn>
+    void post_guarded(Fn&& fn) {
+        asio::post(strand_, [guard = guard_, fn = std::forward<Fn>(fn)]() mutable {
+            std::lock_guard<std::mutex> lock(guard->mutex);
+            if (!guard->detached) {
+                fn();
+            }
+        });
+    }
+
+    // 让处理循环和尚未执行的任务都不再访问this，处理循环正在执行一轮时等这一轮结束
+    // 在strand上或io_context已停止时，挂起的一轮无法在等待期间继续，不能等待：
+    // 自定义的do_write等实现如果真正挂起，不能在这两种情况下析构该sink，
+    // 也不能在只有一个线程的io_context上析构
+    void detach() {
+        auto& ioc = static_cast<asio::io_context&>(strand_.context());
+        std::unique_lock<std::mutex> lock(guard_->mutex);
+        guard_->detached = true;
+        while (guard_->busy && !ioc.stopped() && !strand_.running_in_this_thread()) {
+            guard_->idle.wait_for(lock, std::chrono::milliseconds(10));
+        }
+    }
+
+    // 生产者提交的一条日志，在提交栈中等待处理循环取走
+    struct InboxNode {
+        RecordPtr record;
+        bool urgent;
+        std::uint64_t generation;  // 提交时的fork代数
+        std::chrono::steady_clock::time_point enqueued;
+        InboxNode* next = nullptr;
+    };
+
+    // 把日志压入提交栈，处理循环正在休眠时投递一个任务唤醒它
+    // 压入和读取sleeping_都是seq_cst，与处理循环休眠前先置sleeping_再检查提交栈配对，
+    // 两边至少有一方看到对方，不会在有日志时一直睡到超时
+    void push_inbox(InboxNode* node) {
+        auto* head = inbox_.load(std::memory_order_relaxed);
+        do {
+            node->next = head;
+        } while (!inbox_.compare_exchange_weak(head, node, std::memory_order_seq_cst, std::memory_order_relaxed));
+        if (sleeping_.load(std::memory_order_seq_cst) && sleeping_.exchange(false, std::memory_order_seq_cst)) {
+            post_guarded([this]() {
+                if (idle_timer_) {
+                    idle_timer_->cancel();
+                }
+            });
+        }
+    }
+
+    // 在strand上取走提交栈中的全部日志，按提交顺序放入各通道
+    void take_inbox() {
+        auto* node = inbox_.exchange(nullptr, std::memory_order_acquire);
+        if (!node) {
+            return;
+        }
+        // 栈顶是最后提交的日志，反转后按提交顺序入队
+        InboxNode* ordered = nullptr;
+        while (node) {
+            auto* next = node->next;
+            node->next = ordered;
+            ordered = node;
+            node = next;
+        }
+        auto generation = detail::fork_generation().load(std::memory_order_relaxed);
+        while (ordered) {
+            std::unique_ptr<InboxNode> entry(ordered);
+            ordered = entry->next;
+            // fork之前提交、在子进程中才取走的日志属于父进程，由父进程负责写出
+            if (entry->generation != generation) {
+                release_slots(1);
+                continue;
+            }
+            enqueue(std::move(entry->record), entry->urgent, entry->enqueued);
+        }
+    }
+
+    void discard_inbox() {
+        auto* node = inbox_.exchange(nullptr, std::memory_order_acquire);
+        while (node) {
+            std::unique_ptr<InboxNode> entry(node);
+            node = entry->next;
+        }
+    }
+
+    // 在strand上把一条日志放入对应的通道，enqueued为提交给sink的时间
+    void enqueue(RecordPtr record, bool urgent, std::chrono::steady_clock::time_point enqueued) {
+        if (urgent) {
+            priority_queue_.push({std::move(record), enqueued});
+        } else {
+            if (reorder_window_.load(std::memory_order_relaxed) > 0) {
+                reorder_.push(std::move(record), enqueued);
+            } else {
+                message_queue_.push({std::move(record), enqueued});
+            }
+            evict_overflow();
+            if (adaptive_) {
+                ++adaptive_->arrivals;
+            }
+        }
+        if (oldest_pending_.load(std::memory_order_relaxed) == 0) {
+            set_oldest_pending(enqueued);
+        }
+        if (idle_timer_) {
+            idle_timer_->cancel();  // 由处理循环重新判断是否可以写出
+        }
+    }
+
+    // 为普通通道的一条新日志预留位置，返回false表示队列已满
+    // Block策略下等待其他日志写出，其余策略立即返回
+    bool reserve_slot() {
+        size_t capacity = capacity_.load(std::memory_order_relaxed);
+        if (capacity == 0) {
+            pending_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        if (try_reserve(capacity)) {
+            return true;
+        }
+        if (overflow_policy_.load(std::memory_order_relaxed) != OverflowPolicy::Block) {
+            return false;
+        }
+        return wait_for_slot();
+    }
+
+    // pending_小于容量时加1，多个生产者同时预留也不会超出容量
+    bool try_reserve(size_t capacity) {
+        auto current = pending_.load(std::memory_order_relaxed);
+        while (current < capacity) {
+            if (pending_.compare_exchange_weak(current, current + 1, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Block策略：在条件变量上等待release_slots腾出位置
+    // 负责腾出位置的处理循环运行在sink的io_context上，在它的线程上等待可能永远等不到，
+    // 这时放弃等待，这条日志按DropNewest丢弃
+    bool wait_for_slot() {
+        auto& ioc = static_cast<asio::io_context&>(strand_.context());
+        if (ioc.get_executor().running_in_this_thread()) {
+            return false;
+        }
+        blocked_producers_.fetch_add(1, std::memory_order_seq_cst);
+        std::unique_lock<std::mutex> lock(space_mutex_);
+        bool reserved = true;
+        while (true) {
+            size_t capacity = capacity_.load(std::memory_order_relaxed);
+            if (capacity == 0) {
+                pending_.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+            if (try_reserve(capacity)) {
+                break;
+            }
+            if (!running_) {
+                reserved = false;
+                break;
+            }
+            // 超时只是兜底，正常由release_slots唤醒
+            space_available_.wait_for(lock, std::chrono::milliseconds(10));
+        }
+        blocked_producers_.fetch_sub(1, std::memory_order_relaxed);
+        return reserved;
+    }
+
+    // 日志写出或丢弃后归还位置，有生产者在Block策略下等待时唤醒它们
+    void release_slots(size_t count) {
+        pending_.fetch_sub(count, std::memory_order_seq_cst);
+        if (blocked_producers_.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(space_mutex_);
+            space_available_.notify_all();
+        }
+    }
+
+    // DropOldest策略下队列已满：新日志不再投递，放进生产者一侧的displaced_，
+    // 由一个任务统一移入普通通道并淘汰同样多的最早日志。displaced_本身也以容量为上限，
+    // 超出时直接丢弃其中最早的一条，队列卡住时内存占用也不会增长
+    void displace(const RecordPtr& record) {
+        size_t capacity = std::max<size_t>(capacity_.load(std::memory_order_relaxed), 1);
+        auto generation = detail::fork_generation().load(std::memory_order_relaxed);
+        bool post = false;
+        {
+            std::lock_guard<std::mutex> lock(displaced_mutex_);
+            if (displaced_.size() >= capacity) {
+                // 新日志顶替最早的一条，pending_不变
+                displaced_.pop_front();
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                pending_.fetch_add(1, std::memory_order_relaxed);
+            }
+            displaced_.push_back({record, generation, std::chrono::steady_clock::now()});
+            post = !displaced_posted_;
+            displaced_posted_ = true;
+        }
+        if (post) {
+            post_guarded([this]() { take_displaced(); });
+        }
+    }
+
+    // 在strand上把displaced_中的日志移入普通通道，提交栈中更早提交的日志先入队
+    void take_displaced() {
+        take_inbox();
+        std::deque<DisplacedEntry> taken;
+        {
+            std::lock_guard<std::mutex> lock(displaced_mutex_);
+            taken.swap(displaced_);
+            displaced_posted_ = false;
+        }
+        auto generation = detail::fork_generation().load(std::memory_order_relaxed);
+        for (auto& entry : taken) {
+            if (entry.generation != generation) {
+                release_slots(1);
+                continue;
+            }
+            enqueue(std::move(entry.record), false, entry.enqueued);
+        }
+    }
+
+    // DropOldest策略下，普通通道（包括重排缓冲区）超出容量时丢弃最早的日志
+    void evict_overflow() {
+        size_t capacity = capacity_.load(std::memory_order_relaxed);
+        if (capacity == 0 || overflow_policy_.load(std::memory_order_relaxed) != OverflowPolicy::DropOldest) {
+            return;
+        }
+        while (message_queue_.size() + reorder_.size() > capacity) {
             if (!message_queue_.empty()) {
-                auto [message, level] = std::move(message_queue_.front());
                 message_queue_.pop();
-                co_await do_write(message, level);
+            } else {
+                reorder_.drop_oldest();
+            }
+            release_slots(1);
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void set_oldest_pending(std::chrono::steady_clock::time_point enqueued) {
+        oldest_pending_.store(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            enqueued.time_since_epoch()).count(), std::memory_order_relaxed);
+    }
+
+    // 日志写出完成，把最早的积压时间更新为下一条待写日志的入队时间
+    void record_written(size_t count = 1) {
+        written_.fetch_add(count, std::memory_order_relaxed);
+        release_slots(count);
+        CPP_LOG_PROBE(async_written, static_cast<const void*>(this), count);
+        if (!priority_queue_.empty()) {
+            set_oldest_pending(priority_queue_.front().enqueued);
+        } else if (!message_queue_.empty()) {
+            set_oldest_pending(message_queue_.front().enqueued);
+        } else if (!reorder_.empty()) {
+            set_oldest_pending(reorder_.oldest_enqueued());
+        } else {
+            oldest_pending_.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // 等待strand上的任务完成，io_context停止或者长时间没有任何进展则放弃
+    bool wait_for_strand(asio::io_context& ioc, std::future<void>& future) {
+        auto last_written = written_.load(std::memory_order_relaxed);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (future.wait_for(std::chrono::milliseconds(10)) != std::future_status::ready) {
+            if (ioc.stopped()) {
+                return false;
+            }
+            auto written = written_.load(std::memory_order_relaxed);
+            if (written != last_written) {
+                last_written = written;
+                deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            } else if (std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 在fork出的子进程中丢弃从父进程继承的队列内容，这些日志由父进程写出
+    void reset_after_fork() {
+        auto generation = detail::fork_generation().load(std::memory_order_relaxed);
+        if (generation != generation_) {
+            release_slots(message_queue_.size() + priority_queue_.size() + reorder_.size());
+            message_queue_ = {};
+            priority_queue_ = {};
+            reorder_.clear();
+            generation_ = generation;
+        }
+    }
+
+    // 把重排缓冲区中已经超过窗口的日志按顺序移到普通通道，all为true时全部移出
+    void release_reordered(bool all) {
+        if (reorder_.empty()) {
+            return;
+        }
+        auto until = std::chrono::system_clock::time_point::max();
+        auto window = reorder_window_.load(std::memory_order_relaxed);
+        if (!all && window > 0) {
+            until = std::chrono::system_clock::now() - std::chrono::nanoseconds(window);
+        }
+        auto late = reorder_.release(until, [this](RecordPtr record, std::chrono::steady_clock::time_point enqueued) {
+            message_queue_.push({std::move(record), enqueued});
+        });
+        if (late > 0) {
+            late_.fetch_add(late, std::memory_order_relaxed);
+        }
+        evict_overflow();
+    }
+
+    // 写出高优先级通道的全部日志，每条立即刷新
+    asio::awaitable<void> drain_priority() {
+        while (!priority_queue_.empty()) {
+            auto entry = std::move(priority_queue_.front());
+            priority_queue_.pop();
+            co_await do_write_record(entry.record);
+            co_await do_flush();
+            record_written();
+        }
+    }
+
+    // 从普通通道写出一批日志，高优先级通道有日志时提前结束
+    asio::awaitable<void> drain_batch(size_t batch_size) {
+        if (flush_policy_.load(std::memory_order_relaxed) == FlushPolicy::EveryRecord) {
+            size_t written = 0;
+            while (!message_queue_.empty() && priority_queue_.empty() && written < batch_size) {
+                auto entry = std::move(message_queue_.front());
+                message_queue_.pop();
+                co_await do_write_record(entry.record);
+                co_await do_flush();
+                record_written();
+                ++written;
+            }
+            co_return;
+        }
+
+        // 整批交给do_write_batch，写完刷新一次
+        batch_.clear();
+        while (!message_queue_.empty() && priority_queue_.empty() && batch_.size() < batch_size) {
+            batch_.push_back(std::move(message_queue_.front().record));
+            message_queue_.pop();
+        }
+        if (batch_.empty()) {
+            co_return;
+        }
+        co_await do_write_batch(batch_);
+        co_await do_flush();
+        record_written(batch_.size());
+        batch_.clear();  // 尽早释放记录，让它们回到缓存池
+    }
+
+    // 不再暂留，写出所有通道中的全部日志
+    asio::awaitable<void> drain_all() {
+        take_inbox();
+        release_reordered(true);
+        while (!priority_queue_.empty() || !message_queue_.empty()) {
+            co_await drain_priority();
+            co_await drain_batch(batch_size_.load(std::memory_order_relaxed));
+        }
+    }
+
+    // 通知等待中的flush调用
+    void complete_flush() {
+        for (auto& waiter : flush_waiters_) {
+            waiter->set_value();
+        }
+        flush_waiters_.clear();
+    }
+
+    // 自适应批量的状态，只在strand上访问
+    struct AdaptiveState {
+        explicit AdaptiveState(AdaptiveBatchOptions options_)
+            : options(std::move(options_))
+            , batch_size(Metrics::instance().register_gauge(options.name + ".batch_size"))
+            , flush_interval_us(Metrics::instance().register_gauge(options.name + ".flush_interval_us"))
+            , arrival_rate(Metrics::instance().register_gauge(options.name + ".arrival_rate"))
+            , target(options.min_batch)
+            , interval(0) {
+            publish();
+        }
+
+        // 每个采样周期更新一次到达速率（条/秒，指数平滑）并重新计算批量和刷新间隔
+        void update(std::chrono::steady_clock::time_point now) {
+            auto elapsed = now - window_start;
+            if (elapsed < sample_period) {
+                return;
+            }
+            double seconds = std::chrono::duration<double>(elapsed).count();
+            double instant = static_cast<double>(arrivals) / seconds;
+            rate = rate == 0.0 ? instant : rate * 0.7 + instant * 0.3;
+            arrivals = 0;
+            window_start = now;
+
+            double delay = std::chrono::duration<double>(options.max_delay).count();
+            target = std::clamp(static_cast<size_t>(rate * delay), options.min_batch, options.max_batch);
+            // 凑够一批预计超过max_delay时暂留没有意义，只会让每条日志都等满max_delay
+            interval = std::chrono::microseconds::zero();
+            if (rate > 0.0) {
+                auto fill_time = std::chrono::duration<double>(static_cast<double>(target) / rate);
+                if (fill_time <= options.max_delay) {
+                    interval = std::chrono::duration_cast<std::chrono::microseconds>(fill_time);
+                }
+            }
+            publish();
+        }
+
+        void publish() {
+            batch_size->set(static_cast<double>(target));
+            flush_interval_us->set(static_cast<double>(interval.count()));
+            arrival_rate->set(rate);
+        }
+
+        static constexpr std::chrono::milliseconds sample_period{10};
+
+        AdaptiveBatchOptions options;
+        // 状态释放时（停用自适应批量或sink析构）注销指标
+        GaugeRegistration batch_size;
+        GaugeRegistration flush_interval_us;
+        GaugeRegistration arrival_rate;
+        std::chrono::steady_clock::time_point window_start = std::chrono::steady_clock::now();
+        std::uint64_t arrivals = 0;
+        double rate = 0.0;
+        size_t target;
+        std::chrono::microseconds interval;  // 0表示不暂留
+    };
+
+    // 本轮是否写出普通通道：固定批量时总是写出；自适应时凑够一批或者最早的日志已经等了刷新间隔
+    bool batch_due(size_t batch_size) const {
+        if (!adaptive_ || message_queue_.empty() || message_queue_.size() >= batch_size) {
+            return true;
+        }
+        return std::chrono::steady_clock::now() - message_queue_.front().enqueued >= adaptive_->interval;
+    }
+
+    // Block策略下单次休眠的时间：不超过timeout，也不超过被重排窗口或自适应批量暂留的日志到期的时间
+    std::chrono::nanoseconds idle_sleep() const {
+        std::chrono::nanoseconds sleep = std::chrono::microseconds(block_timeout_.load(std::memory_order_relaxed));
+        auto now = std::chrono::system_clock::now();
+        if (!reorder_.empty()) {
+            auto due = reorder_.oldest() + std::chrono::nanoseconds(reorder_window_.load(std::memory_order_relaxed));
+            sleep = std::min<std::chrono::nanoseconds>(sleep, due - now);
+        }
+        if (adaptive_ && !message_queue_.empty()) {
+            auto due = message_queue_.front().enqueued + adaptive_->interval;
+            sleep = std::min<std::chrono::nanoseconds>(sleep, due - std::chrono::steady_clock::now());
+        }
+        return std::max(sleep, std::chrono::nanoseconds::zero());
+    }
+
+    // 异步处理循环
+    // 高优先级通道总是先处理且每条立即刷新，普通通道按批写入后统一刷新
+    // 每一轮由guard的enter/leave包围，enter时检查是否已经脱离this；一轮之内的co_await不持有guard的mutex，
+    // detach会等这一轮结束。一轮结束之后的空闲等待只用局部变量，不访问this
+    asio::awaitable<void> process_loop(std::shared_ptr<LoopGuard> guard) {
+        size_t idle_rounds = 0;
+        while (true) {
+            std::optional<asio::steady_timer> idle_timer;
+            if (!guard->enter()) {
+                co_return;
+            }
+            idle_timer_ = nullptr;
+            sleeping_.store(false, std::memory_order_relaxed);
+
+            if (!running_) {
+                // 退出前写完剩余的日志
+                co_await drain_all();
+                complete_flush();
+                loop_done_.set_value();
+                // 之后shutdown随时可能返回，尚未执行的任务（例如唤醒定时器）不能再访问this
+                guard->leave(true);
+                co_return;
+            }
+
+            auto written = written_.load(std::memory_order_relaxed);
+            reset_after_fork();
+            take_inbox();
+            co_await drain_priority();
+            if (!flush_waiters_.empty()) {
+                co_await drain_all();
+                co_await do_flush();
+                complete_flush();
+            }
+            release_reordered(false);
+            size_t batch_size = batch_size_.load(std::memory_order_relaxed);
+            if (adaptive_) {
+                adaptive_->update(std::chrono::steady_clock::now());
+                batch_size = adaptive_->target;
+            }
+            if (batch_due(batch_size)) {
+                co_await drain_batch(batch_size);
+            }
+
+            // 连续空闲超过spin_rounds轮之后按等待策略让出CPU或者休眠
+            idle_rounds = written_.load(std::memory_order_relaxed) == written ? idle_rounds + 1 : 0;
+            auto strategy = idle_rounds > spin_rounds ? wait_strategy_.load(std::memory_order_relaxed)
+                                                      : WaitStrategy::Spin;
+            auto strand = strand_;
+            if (strategy == WaitStrategy::Block) {
+                // 先置sleeping_再检查提交栈，期间压入的日志要么在这里看到，要么由生产者唤醒
+                sleeping_.store(true, std::memory_order_seq_cst);
+                if (inbox_.load(std::memory_order_seq_cst)) {
+                    sleeping_.store(false, std::memory_order_relaxed);
+                    strategy = WaitStrategy::Spin;
+                } else {
+                    idle_timer.emplace(strand, idle_sleep());
+                    idle_timer_ = &*idle_timer;
+                }
+            }
+            guard->leave();
+
+            if (idle_timer) {
+                boost::system::error_code ec;
+                co_await idle_timer->async_wait(asio::redirect_error(asio::use_awaitable, ec));
+            } else {
+                if (strategy == WaitStrategy::SpinYield) {
+                    std::this_thread::yield();
+                }
+                co_await asio::post(strand, asio::use_awaitable);
             }
-            co_await asio::post(strand_, asio::use_awaitable);
         }
     }
 
     struct QueueEntry {
-        std::string message;
-        Level level;
+        RecordPtr record;
+        std::chrono::steady_clock::time_point enqueued;  // 提交给sink的时间
+    };
+
+    // 生产者一侧暂存的日志，带着提交时的fork代数
+    struct DisplacedEntry {
+        RecordPtr record;
+        std::uint64_t generation;
+        std::chrono::steady_clock::time_point enqueued;
     };
 
+    static constexpr size_t spin_rounds = 64;  // 连续空闲这么多轮之后才让出CPU或休眠
+
+    // 进程内递增的sink序号
+    static std::uint64_t next_sink_id() {
+        static std::atomic<std::uint64_t> next{0};
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::shared_ptr<LoopGuard> guard_ = std::make_shared<LoopGuard>();
+    std::unique_ptr<SinkExecutor> executor_;  // 独立执行器，使用共享io_context时为空
     asio::strand<asio::io_context::executor_type> strand_;
-    std::queue<QueueEntry> message_queue_;
+    asio::steady_timer* idle_timer_ = nullptr;  // Block策略下处理循环正在其上休眠的定时器，只在strand上访问
+    std::atomic<InboxNode*> inbox_{nullptr};  // 生产者提交的日志，后提交的在栈顶
+    std::atomic<bool> sleeping_{false};       // 处理循环将要或正在定时器上休眠
+    std::queue<QueueEntry> message_queue_;   // 普通通道
+    std::queue<QueueEntry> priority_queue_;  // 高优先级通道
+    ReorderBuffer reorder_;                  // 启用重排窗口时普通通道的日志先放在这里
+    std::shared_ptr<AdaptiveState> adaptive_;  // 启用自适应批量时非空，只在strand上访问
+    std::vector<RecordPtr> batch_;           // 当前正在写出的一批日志，只在strand上访问
+    std::vector<std::shared_ptr<std::promise<void>>> flush_waiters_;  // 等待中的flush调用，只在strand上访问
+    std::mutex displaced_mutex_;
+    std::deque<DisplacedEntry> displaced_;   // DropOldest策略下队列满时提交的日志
+    bool displaced_posted_ = false;          // 已经投递了移入displaced_的任务，持有displaced_mutex_时访问
+    std::mutex space_mutex_;
+    std::condition_variable space_available_;  // Block策略下等待位置的生产者
+    std::atomic<size_t> blocked_producers_{0};
     std::atomic<bool> running_;
+    std::atomic<bool> shutdown_called_{false};
+    std::atomic<std::uint64_t> written_{0};  // 已写出的日志条数
+    std::atomic<size_t> pending_{0};         // 已提交未写出的日志条数
+    std::atomic<size_t> capacity_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+    std::atomic<std::int64_t> reorder_window_{0};  // 纳秒
+    std::atomic<std::uint64_t> late_{0};
+    std::atomic<OverflowPolicy> overflow_policy_{OverflowPolicy::DropNewest};
+    std::atomic<FlushPolicy> flush_policy_{FlushPolicy::EveryBatch};
+    std::atomic<WaitStrategy> wait_strategy_{WaitStrategy::Block};
+    std::atomic<std::int64_t> block_timeout_{10000};  // 微秒
+    std::atomic<std::int64_t> oldest_pending_{0};  // 最早一条未写出日志的入队时间（steady_clock，纳秒），0表示没有
+    std::uint64_t generation_ = detail::fork_generation().load(std::memory_order_relaxed);
+    std::promise<void> loop_done_;
+    std::future<void> loop_done_future_ = loop_done_.get_future();
+    std::atomic<Level> priority_level_{Level::Error};
+    std::atomic<size_t> batch_size_{64};
+    std::uint64_t sink_id_ = next_sink_id();  // 进程内唯一，用于默认的指标名
 };
 
 // 异步控制台输出
 class AsyncConsoleSink : public AsyncLogSink {
 public:
+    AsyncConsoleSink() = default;
+
     explicit AsyncConsoleSink(asio::io_context& ioc)
         : AsyncLogSink(ioc) {}
 
+    explicit AsyncConsoleSink(dedicated_executor_t tag)
+        : AsyncLogSink(tag) {}
+
+    ~AsyncConsoleSink() override {
+        shutdown();
+    }
+
 protected:
     asio::awaitable<void> do_write(const std::string& message, Level level) override {
         std::cout << message;
+        co_return;
+    }
+
+    asio::awaitable<void> do_write_record(const RecordPtr& record) override {
+        write_text(std::cout, record->text(*formatter_, scratch_));
+        co_return;
+    }
+
+    // 整批拼接到复用的缓冲区后一次写出
+    asio::awaitable<void> do_write_batch(std::span<const RecordPtr> records) override {
+        buffer_.clear();
+        for (const auto& record : records) {
+            buffer_ += record->text(*formatter_, scratch_);
+        }
+        write_text(std::cout, buffer_);
+        co_return;
+    }
+
+    asio::awaitable<void> do_flush() override {
         std::cout.flush();
         co_return;
     }
+
+private:
+    std::string scratch_;  // 文本缓存被其他格式化器占用时格式化到这里，只在strand上访问
+    std::string buffer_;   // 一批日志拼接后的内容，只在strand上访问
 };
 
 // 异步文件输出
 class AsyncFileSink : public AsyncLogSink {
 public:
+    explicit AsyncFileSink(const std::string& filename)
+        : filename_(filename)
+        , file_(filename, std::ios::app | std::ios::binary) {}
+
     AsyncFileSink(asio::io_context& ioc, const std::string& filename)
         : AsyncLogSink(ioc)
-        , file_(filename, std::ios::app) {}
+        , filename_(filename)
+        , file_(filename, std::ios::app | std::ios::binary) {}
+
+    AsyncFileSink(dedicated_executor_t tag, const std::string& filename)
+        : AsyncLogSink(tag)
+        , filename_(filename)
+        , file_(filename, std::ios::app | std::ios::binary) {}
+
+    ~AsyncFileSink() override {
+        shutdown();
+    }
+
+    // 在入队之前检查磁盘空间，被丢弃的日志不会占用队列
+    void write_record(const RecordPtr& record) override {
+        auto level = record->context().level;
+        if (disk_monitor_ && should_log(level) && !disk_monitor_->admit(level)) {
+            return;
+        }
+        AsyncLogSink::write_record(record);
+    }
+
+    // 设置磁盘空间监视器，剩余空间不足时逐级丢弃低等级日志
+    void set_disk_monitor(std::shared_ptr<DiskPressureMonitor> monitor) {
+        disk_monitor_ = std::move(monitor);
+    }
+
+    // 为日志文件所在的卷创建磁盘空间监视器
+    void enable_disk_guard(DiskPressureOptions options = {}) {
+        set_disk_monitor(std::make_shared<DiskPressureMonitor>(filename_, options));
+    }
+
+    std::shared_ptr<DiskPressureMonitor> disk_monitor() const {
+        return disk_monitor_;
+    }
 
 protected:
     asio::awaitable<void> do_write(const std::string& message, Level level) override {
         // 移除颜色代码后写入文件
-        file_ << color::strip_color_codes(message);
+        write_text(file_, file_text(*formatter_, message, scratch_));
+        co_return;
+    }
+
+    // 直接写出记录中缓存的去除颜色代码的文本，二进制格式编码到scratch_中
+    asio::awaitable<void> do_write_record(const RecordPtr& record) override {
+        write_text(file_, file_record_text(*formatter_, *record, scratch_));
+        co_return;
+    }
+
+    // 整批拼接到复用的缓冲区后一次写出
+    asio::awaitable<void> do_write_batch(std::span<const RecordPtr> records) override {
+        buffer_.clear();
+        for (const auto& record : records) {
+            append_file_record(*formatter_, *record, buffer_, scratch_);
+        }
+        write_text(file_, buffer_);
+        co_return;
+    }
+
+    asio::awaitable<void> do_flush() override {
         file_.flush();
         co_return;
     }
 
 private:
+    std::string filename_;
     std::ofstream file_;
+    std::shared_ptr<DiskPressureMonitor> disk_monitor_;
+    std::string scratch_;  // 去除颜色代码或者文本缓存被占用时的临时文本，只在strand上访问
+    std::string buffer_;   // 一批日志拼接后的内容，只在strand上访问
+};
+
+// 通用异步适配器
+// 把任意同步sink包装成异步sink：生产者线程只增加日志记录的引用计数，
+// 由后台线程批量调用被包装sink的write，每批结束后调用flush。
+// 格式化使用被包装sink自己的格式化器，适配器的set_formatter不起作用
+class AsyncSinkAdapter : public AsyncLogSink {
+public:
+    // 格式化器取被包装sink的格式化器，格式化好的批次中的文本由被包装的sink直接使用
+    explicit AsyncSinkAdapter(std::shared_ptr<LogSink> sink)
+        : sink_(std::move(sink)) {
+        formatter_ = sink_->formatter();
+    }
+
+    AsyncSinkAdapter(asio::io_context& ioc, std::shared_ptr<LogSink> sink)
+        : AsyncLogSink(ioc)
+        , sink_(std::move(sink)) {
+        formatter_ = sink_->formatter();
+    }
+
+    AsyncSinkAdapter(dedicated_executor_t tag, std::shared_ptr<LogSink> sink)
+        : AsyncLogSink(tag)
+        , sink_(std::move(sink)) {
+        formatter_ = sink_->formatter();
+    }
+
+    ~AsyncSinkAdapter() override {
+        shutdown();
+    }
+
+    // 被包装sink不接受的等级不进入队列
+    void write_record(const RecordPtr& record) override {
+        if (!sink_->should_log(record->context().level)) {
+            return;
+        }
+        AsyncLogSink::write_record(record);
+    }
+
+    std::shared_ptr<LogSink> sink() const {
+        return sink_;
+    }
+
+    double pressure() const override {
+        return std::max(AsyncLogSink::pressure(), sink_->pressure());
+    }
+
+protected:
+    asio::awaitable<void> do_write_record(const RecordPtr& record) override {
+        sink_->write_record(record);
+        co_return;
+    }
+
+    asio::awaitable<void> do_write_batch(std::span<const RecordPtr> records) override {
+        sink_->write_batch(records);
+        co_return;
+    }
+
+    // 日志记录直接交给被包装的sink，不会经过这里
+    asio::awaitable<void> do_write(const std::string&, Level) override {
+        co_return;
+    }
+
+    asio::awaitable<void> do_flush() override {
+        sink_->flush();
+        co_return;
+    }
+
+private:
+    std::shared_ptr<LogSink> sink_;
 };
 
 } // namespace cpp_log
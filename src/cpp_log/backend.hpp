@@ -0,0 +1,433 @@
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <system_error>
+#include <optional>
+#include <atomic>
+#include <cstdint>
+
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#endif
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace cpp_log {
+
+namespace asio = boost::asio;
+
+// 后台工作线程配置
+struct BackendOptions {
+    size_t thread_count = 1;        // 工作线程数量
+    std::vector<int> cpu_affinity;  // 绑定的CPU编号，第i个线程绑定到cpu_affinity[i % size]，为空则不绑定
+    std::optional<int> sched_policy; // 调度策略（SCHED_OTHER/SCHED_FIFO/SCHED_RR等），为空则保持默认
+    int sched_priority = 0;         // 调度优先级，仅在设置了sched_policy时生效
+};
+
+namespace detail {
+    // 子进程中每次fork后递增，用来识别从父进程继承下来的队列内容
+    inline std::atomic<std::uint64_t>& fork_generation() {
+        static std::atomic<std::uint64_t> generation{0};
+        return generation;
+    }
+} // namespace detail
+
+// fork前的处理阶段
+// 先让所有Lock阶段的对象取得锁，这时后台线程仍在运行，持有锁并等待队列腾出空间的生产者可以完成；
+// 之后才停止Quiesce阶段对象的线程。fork后父进程按相反的顺序恢复，子进程先恢复Lock阶段
+enum class ForkStage {
+    Lock,    // 日志记录器：取得锁，阻止新的日志进入
+    Quiesce  // 执行器：停止后台线程
+};
+
+// fork前后需要处理的对象，例如持有锁的日志记录器
+class ForkHandler {
+public:
+    virtual ~ForkHandler() = default;
+    virtual void prepare_fork() = 0;  // fork前在父进程中调用
+    virtual void after_fork_parent() = 0;
+    virtual void after_fork_child() = 0;
+
+    virtual ForkStage fork_stage() const {
+        return ForkStage::Quiesce;
+    }
+};
+
+// 进程级的日志后台
+// 持有一个io_context和一组工作线程，所有Logger和异步sink默认都挂在它上面，
+// 避免每个组件各自创建io_context和线程
+class LogBackend {
+public:
+    static LogBackend& instance() {
+        static LogBackend backend;
+        return backend;
+    }
+
+    LogBackend(const LogBackend&) = delete;
+    LogBackend& operator=(const LogBackend&) = delete;
+
+    ~LogBackend() {
+        stop();
+    }
+
+    // 获取io_context
+    asio::io_context& get_io_context() { return *io_context_; }
+
+    std::shared_ptr<asio::io_context> io_context_ptr() { return io_context_; }
+
+    // 更新配置，如果工作线程已经在运行则按新配置重启
+    void configure(BackendOptions options) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bool was_running = !workers_.empty();
+        if (was_running) {
+            stop_workers();
+        }
+        options_ = std::move(options);
+        if (was_running) {
+            start_workers();
+        }
+    }
+
+    // 设置工作线程数量
+    void set_thread_count(size_t count) {
+        BackendOptions options = this->options();
+        options.thread_count = count;
+        configure(std::move(options));
+    }
+
+    BackendOptions options() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return options_;
+    }
+
+    size_t thread_count() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return workers_.size();
+    }
+
+    // 启动工作线程，已经启动时不做任何事情
+    void start() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (workers_.empty()) {
+            start_workers();
+        }
+    }
+
+    // 停止并等待所有工作线程退出，未处理的任务保留在io_context中
+    void stop() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_workers();
+    }
+
+    // 注册和注销fork处理对象
+    void add_fork_handler(ForkHandler* handler) {
+        std::lock_guard<std::mutex> lock(fork_mutex_);
+        fork_handlers_.push_back(handler);
+    }
+
+    void remove_fork_handler(ForkHandler* handler) {
+        std::lock_guard<std::mutex> lock(fork_mutex_);
+        std::erase(fork_handlers_, handler);
+    }
+
+private:
+    LogBackend()
+        : io_context_(std::make_shared<asio::io_context>())
+        , work_guard_(asio::make_work_guard(*io_context_)) {
+#if defined(__unix__) || defined(__APPLE__)
+        pthread_atfork(&LogBackend::on_fork_prepare, &LogBackend::on_fork_parent, &LogBackend::on_fork_child);
+#endif
+        start();
+    }
+
+    // fork前：先取得所有日志记录器的锁（单线程版本关闭各自的fork闸门），再停止执行器和工作线程，
+    // 未处理的任务和队列保留在父进程中，fork后继续处理
+    static void on_fork_prepare() {
+        auto& self = instance();
+        self.fork_mutex_.lock();
+        self.for_each_fork_handler(ForkStage::Lock, &ForkHandler::prepare_fork);
+        self.for_each_fork_handler(ForkStage::Quiesce, &ForkHandler::prepare_fork);
+        self.mutex_.lock();
+        self.was_running_before_fork_ = !self.workers_.empty();
+        self.stop_workers();
+        self.io_context_->notify_fork(asio::execution_context::fork_prepare);
+    }
+
+    // fork后的父进程：恢复工作线程
+    static void on_fork_parent() {
+        auto& self = instance();
+        self.io_context_->notify_fork(asio::execution_context::fork_parent);
+        if (self.was_running_before_fork_) {
+            self.start_workers(false);
+        }
+        self.mutex_.unlock();
+        self.for_each_fork_handler(ForkStage::Quiesce, &ForkHandler::after_fork_parent);
+        self.for_each_fork_handler(ForkStage::Lock, &ForkHandler::after_fork_parent);
+        self.fork_mutex_.unlock();
+    }
+
+    // fork后的子进程：工作线程不存在了，重置继承下来的状态后重新启动
+    // 子进程中只有一个线程，恢复顺序不影响死锁。glibc会把已不存在的线程的栈交给新线程复用，
+    // 那些线程栈上的处理对象（例如单线程日志记录器的fork闸门）在任何线程启动之后都可能已被覆盖，
+    // 因此先恢复所有Lock阶段的对象、挑出执行器，之后启动线程时不再访问其他处理对象
+    static void on_fork_child() {
+        auto& self = instance();
+        self.io_context_->notify_fork(asio::execution_context::fork_child);
+        detail::fork_generation().fetch_add(1, std::memory_order_relaxed);
+        std::vector<ForkHandler*> executors;
+        for (auto* handler : self.fork_handlers_) {
+            if (handler->fork_stage() == ForkStage::Quiesce) {
+                executors.push_back(handler);
+            } else {
+                handler->after_fork_child();
+            }
+        }
+        for (auto* handler : executors) {
+            handler->after_fork_child();
+        }
+        if (self.was_running_before_fork_) {
+            self.start_workers(false);
+        }
+        self.mutex_.unlock();
+        self.fork_mutex_.unlock();
+    }
+
+    // 按注册顺序调用某一阶段的处理对象，调用方持有fork_mutex_
+    void for_each_fork_handler(ForkStage stage, void (ForkHandler::*action)()) {
+        for (auto* handler : fork_handlers_) {
+            if (handler->fork_stage() == stage) {
+                (handler->*action)();
+            }
+        }
+    }
+
+    // strict为false时用于fork回调，异常不能从pthread_atfork的回调中抛出：
+    // 设置CPU亲和性或调度策略失败时只报告到stderr，线程不绑定、按默认调度继续运行
+    void start_workers(bool strict = true) {
+        io_context_->restart();
+        size_t count = std::max<size_t>(options_.thread_count, 1);
+        for (size_t i = 0; i < count; ++i) {
+            workers_.emplace_back([ioc = io_context_]() {
+                ioc->run();
+            });
+            try {
+                apply_thread_options(workers_.back(), i);
+            } catch (const std::system_error& error) {
+                if (strict) {
+                    throw;
+                }
+                std::cerr << "cpp_log: " << error.what() << " after fork, the worker thread runs without it\n";
+            }
+        }
+    }
+
+    void stop_workers() {
+        if (workers_.empty()) {
+            return;
+        }
+        io_context_->stop();
+        for (auto& worker : workers_) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+        workers_.clear();
+    }
+
+    // 设置CPU亲和性和调度策略
+    void apply_thread_options(std::thread& worker, size_t index) {
+#if defined(__linux__)
+        auto handle = worker.native_handle();
+        if (!options_.cpu_affinity.empty()) {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(options_.cpu_affinity[index % options_.cpu_affinity.size()], &cpus);
+            if (int err = pthread_setaffinity_np(handle, sizeof(cpus), &cpus); err != 0) {
+                throw std::system_error(err, std::system_category(), "Failed to set log backend CPU affinity");
+            }
+        }
+        if (options_.sched_policy) {
+            sched_param param{};
+            param.sched_priority = options_.sched_priority;
+            if (int err = pthread_setschedparam(handle, *options_.sched_policy, &param); err != 0) {
+                throw std::system_error(err, std::system_category(), "Failed to set log backend scheduling policy");
+            }
+        }
+#else
+        (void)worker;
+        (void)index;
+#endif
+    }
+
+    mutable std::mutex mutex_;
+    std::shared_ptr<asio::io_context> io_context_;
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard_;
+    std::vector<std::thread> workers_;
+    BackendOptions options_;
+    std::mutex fork_mutex_;
+    std::vector<ForkHandler*> fork_handlers_;
+    bool was_running_before_fork_ = false;
+};
+
+namespace detail {
+    // 缓存行大小，用于把各自独立写入的原子变量分开
+    inline constexpr size_t cache_line_size = 64;
+
+    // 单线程日志记录器（SingleThreaded）的fork闸门
+    // 单线程版本没有真实的锁，fork前无法像多线程版本那样取得锁。每个记录器持有自己的闸门：
+    // 分发期间置busy_，fork前关闭闸门并等待busy_清零，子进程不会继承被生产者占用的asio内部锁；
+    // 闸门关闭期间新的分发在闸门外等待。busy_只由所有者线程写入并独占一个缓存行，
+    // 不同记录器之间不会争用。这是单线程版本中唯一的原子操作，没有异步sink时记录器不进入闸门
+    class ForkGate : public ForkHandler {
+    public:
+        ForkGate() {
+            LogBackend::instance().add_fork_handler(this);
+        }
+
+        ~ForkGate() override {
+            LogBackend::instance().remove_fork_handler(this);
+        }
+
+        ForkGate(const ForkGate&) = delete;
+        ForkGate& operator=(const ForkGate&) = delete;
+
+        // 是否需要进入闸门，由记录器在sink列表变化时设置，只在所有者线程上读写
+        bool enabled() const { return enabled_; }
+        void set_enabled(bool enabled) { enabled_ = enabled; }
+
+        // busy_的写入与closed_的读取之间需要seq_cst，与prepare_fork中相反顺序的两步配对
+        void enter() {
+            busy_.store(true, std::memory_order_seq_cst);
+            while (closed_.load(std::memory_order_seq_cst)) {
+                busy_.store(false, std::memory_order_release);
+                while (closed_.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                busy_.store(true, std::memory_order_seq_cst);
+            }
+        }
+
+        void leave() {
+            busy_.store(false, std::memory_order_release);
+        }
+
+        void prepare_fork() override {
+            closed_.store(true, std::memory_order_seq_cst);
+            while (busy_.load(std::memory_order_seq_cst)) {
+                std::this_thread::yield();
+            }
+        }
+
+        void after_fork_parent() override {
+            closed_.store(false, std::memory_order_release);
+        }
+
+        void after_fork_child() override {
+            busy_.store(false, std::memory_order_relaxed);
+            closed_.store(false, std::memory_order_release);
+        }
+
+        ForkStage fork_stage() const override { return ForkStage::Lock; }
+
+    private:
+        alignas(cache_line_size) std::atomic<bool> busy_{false};
+        std::atomic<bool> closed_{false};
+        bool enabled_ = false;
+    };
+
+    // 分发期间持有闸门
+    class ForkGateScope {
+    public:
+        explicit ForkGateScope(ForkGate& gate) : gate_(gate) { gate_.enter(); }
+        ~ForkGateScope() { gate_.leave(); }
+
+        ForkGateScope(const ForkGateScope&) = delete;
+        ForkGateScope& operator=(const ForkGateScope&) = delete;
+
+    private:
+        ForkGate& gate_;
+    };
+
+    // 多线程版本用锁处理fork，不需要闸门
+    struct NoForkGate {};
+} // namespace detail
+
+// 独立的执行器：一个io_context和专用线程（默认一个）
+// 用于把慢速sink与其他sink隔离开，一个sink阻塞时只影响它自己
+class SinkExecutor : public ForkHandler {
+public:
+    explicit SinkExecutor(size_t thread_count = 1)
+        : io_context_(std::make_shared<asio::io_context>())
+        , work_guard_(asio::make_work_guard(*io_context_))
+        , thread_count_(std::max<size_t>(thread_count, 1)) {
+        start();
+        LogBackend::instance().add_fork_handler(this);
+    }
+
+    SinkExecutor(const SinkExecutor&) = delete;
+    SinkExecutor& operator=(const SinkExecutor&) = delete;
+
+    ~SinkExecutor() override {
+        LogBackend::instance().remove_fork_handler(this);
+        stop();
+    }
+
+    asio::io_context& get_io_context() { return *io_context_; }
+
+    void prepare_fork() override {
+        stop();
+        io_context_->notify_fork(asio::execution_context::fork_prepare);
+    }
+
+    void after_fork_parent() override {
+        io_context_->notify_fork(asio::execution_context::fork_parent);
+        start();
+    }
+
+    void after_fork_child() override {
+        io_context_->notify_fork(asio::execution_context::fork_child);
+        start();
+    }
+
+private:
+    void start() {
+        io_context_->restart();
+        for (size_t i = 0; i < thread_count_; ++i) {
+            threads_.emplace_back([ioc = io_context_]() {
+                ioc->run();
+            });
+        }
+    }
+
+    void stop() {
+        io_context_->stop();
+        for (auto& thread : threads_) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+        threads_.clear();
+    }
+
+    std::shared_ptr<asio::io_context> io_context_;
+    asio::executor_work_guard<asio::io_context::executor_type> work_guard_;
+    size_t thread_count_;
+    std::vector<std::thread> threads_;
+};
+
+// 构造异步sink时使用的标记，表示为该sink创建独立的执行器
+struct dedicated_executor_t {
+    explicit dedicated_executor_t() = default;
+};
+inline constexpr dedicated_executor_t dedicated_executor{};
+
+} // namespace cpp_log
@@ -1,6 +1,6 @@
 #pragma once
 #include <string>
-#include <regex>
+#include <string_view>
 #include "cpp_log/level.hpp"
 
 namespace cpp_log {
@@ -18,10 +18,64 @@ constexpr const char* cyan    = "\033[36m";
 constexpr const char* white   = "\033[37m";
 constexpr const char* bold_red = "\033[1;31m";
 
+// 把移除ANSI颜色代码（ESC [ 数字或分号 m）后的文本追加到out
+inline void append_without_color_codes(std::string_view str, std::string& out) {
+    size_t start = 0;
+    size_t pos = 0;
+    while ((pos = str.find('\033', pos)) != std::string_view::npos) {
+        size_t end = pos + 1;
+        if (end < str.size() && str[end] == '[') {
+            ++end;
+            while (end < str.size() && ((str[end] >= '0' && str[end] <= '9') || str[end] == ';')) {
+                ++end;
+            }
+            if (end < str.size() && str[end] == 'm') {
+                out.append(str, start, pos - start);
+                start = end + 1;
+                pos = start;
+                continue;
+            }
+        }
+        ++pos;
+    }
+    out.append(str, start, std::string_view::npos);
+}
+
+// 就地移除str中的颜色代码，不分配内存
+inline void erase_color_codes(std::string& str) {
+    size_t start = 0;
+    size_t pos = 0;
+    size_t out = 0;  // 已保留的文本长度，总是不大于start，向前移动不会覆盖未读的部分
+    auto keep = [&](size_t count) {
+        std::char_traits<char>::move(str.data() + out, str.data() + start, count);
+        out += count;
+    };
+    while ((pos = str.find('\033', pos)) != std::string::npos) {
+        size_t end = pos + 1;
+        if (end < str.size() && str[end] == '[') {
+            ++end;
+            while (end < str.size() && ((str[end] >= '0' && str[end] <= '9') || str[end] == ';')) {
+                ++end;
+            }
+            if (end < str.size() && str[end] == 'm') {
+                keep(pos - start);
+                start = end + 1;
+                pos = start;
+                continue;
+            }
+        }
+        ++pos;
+    }
+    keep(str.size() - start);
+    str.resize(out);
+}
+
 // 移除ANSI颜色代码
-inline std::string strip_color_codes(const std::string& str) {
-    static const std::regex color_regex("\033\\[[0-9;]*m");
-    return std::regex_replace(str, color_regex, "");
+inline std::string strip_color_codes(std::string_view str) {
+    std::string result;
+    result.reserve(str.size());
+    append_without_color_codes(str, result);
+    return result;
 }
 
 } // namespace color
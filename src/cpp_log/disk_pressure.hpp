@@ -0,0 +1,178 @@
+#pragma once
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <system_error>
+#include "cpp_log/backend.hpp"
+#include "cpp_log/level.hpp"
+
+namespace cpp_log {
+
+namespace asio = boost::asio;
+
+// 磁盘空间保护配置，剩余空间低于各阈值时逐级提高写入等级
+struct DiskPressureOptions {
+    std::uint64_t warning_below = 1024ull * 1024 * 1024;  // 低于该值只写Warning及以上
+    std::uint64_t error_below = 512ull * 1024 * 1024;     // 低于该值只写Error及以上
+    std::uint64_t stop_below = 128ull * 1024 * 1024;      // 低于该值停止写入
+    std::chrono::milliseconds check_interval{1000};       // 检查剩余空间的间隔
+    // 读取剩余空间，为空时使用std::filesystem::space，返回nullopt表示无法获取
+    // 在构造函数所在线程和后台线程上调用
+    std::function<std::optional<std::uint64_t>(const std::filesystem::path&)> space_probe;
+};
+
+// 磁盘空间监视器
+// 在后台定期检查日志所在卷的剩余空间（不在每次写入时检查），
+// 文件sink在写入前询问当前允许的最低等级，并统计被丢弃的日志
+class DiskPressureMonitor {
+public:
+    DiskPressureMonitor(std::filesystem::path path, DiskPressureOptions options = {})
+        : DiskPressureMonitor(std::move(path), options, LogBackend::instance().get_io_context()) {}
+
+    DiskPressureMonitor(std::filesystem::path path, DiskPressureOptions options, asio::io_context& ioc)
+        : state_(std::make_shared<State>(std::move(path), std::move(options), ioc)) {
+        state_->check();
+        asio::co_spawn(state_->strand, check_loop(state_), asio::detached);
+    }
+
+    // 取消后台正在等待的定时器，检查协程随即退出，不会在析构之后再检查
+    ~DiskPressureMonitor() {
+        state_->running = false;
+        asio::post(state_->strand, [state = state_]() {
+            if (state->timer) {
+                state->timer->cancel();
+            }
+        });
+    }
+
+    DiskPressureMonitor(const DiskPressureMonitor&) = delete;
+    DiskPressureMonitor& operator=(const DiskPressureMonitor&) = delete;
+
+    // 该等级的日志当前是否允许写入，不允许时计入丢弃数
+    bool admit(Level level) {
+        if (static_cast<int>(level) >= state_->min_level.load(std::memory_order_relaxed)) {
+            return true;
+        }
+        state_->dropped[static_cast<size_t>(level)].fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // 是否仍在写入，剩余空间低于stop_below时为false
+    bool writing() const {
+        return state_->min_level.load(std::memory_order_relaxed) <= static_cast<int>(Level::Fatal);
+    }
+
+    // 当前允许写入的最低等级
+    Level min_level() const {
+        int level = state_->min_level.load(std::memory_order_relaxed);
+        return static_cast<Level>(std::min(level, static_cast<int>(Level::Fatal)));
+    }
+
+    // 最近一次检查得到的剩余空间
+    std::uint64_t available() const {
+        return state_->available.load(std::memory_order_relaxed);
+    }
+
+    // 因磁盘空间不足被丢弃的日志条数
+    std::uint64_t dropped(Level level) const {
+        return state_->dropped[static_cast<size_t>(level)].load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t dropped() const {
+        std::uint64_t total = 0;
+        for (const auto& count : state_->dropped) {
+            total += count.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+private:
+    // 与后台检查协程共享的状态
+    struct State {
+        State(std::filesystem::path path_, DiskPressureOptions options_, asio::io_context& ioc)
+            : path(std::move(path_)), options(std::move(options_)), strand(asio::make_strand(ioc)) {
+            // 无法读取状态（如文件名过长、无权限）时按非目录处理，不让构造函数抛异常
+            std::error_code ec;
+            if (path.has_filename() && !std::filesystem::is_directory(path, ec)) {
+                path = path.parent_path();
+            }
+            if (path.empty()) {
+                path = ".";
+            }
+        }
+
+        // 读取剩余空间并更新允许的最低等级
+        void check() {
+            auto space = read_space();
+            if (!space) {
+                return;  // 无法获取时保持上一次的状态
+            }
+            available.store(*space, std::memory_order_relaxed);
+
+            int level = static_cast<int>(Level::Debug);
+            if (*space < options.stop_below) {
+                level = static_cast<int>(Level::Fatal) + 1;
+            } else if (*space < options.error_below) {
+                level = static_cast<int>(Level::Error);
+            } else if (*space < options.warning_below) {
+                level = static_cast<int>(Level::Warning);
+            }
+            min_level.store(level, std::memory_order_relaxed);
+        }
+
+        std::optional<std::uint64_t> read_space() const {
+            if (options.space_probe) {
+                return options.space_probe(path);
+            }
+            std::error_code ec;
+            auto info = std::filesystem::space(path, ec);
+            if (ec) {
+                return std::nullopt;
+            }
+            return info.available;
+        }
+
+        std::filesystem::path path;
+        DiskPressureOptions options;
+        asio::strand<asio::io_context::executor_type> strand;
+        asio::steady_timer* timer = nullptr;  // 检查协程正在等待的定时器，只在strand上访问
+        std::atomic<int> min_level{static_cast<int>(Level::Debug)};
+        std::atomic<std::uint64_t> available{0};
+        std::array<std::atomic<std::uint64_t>, 5> dropped{};
+        std::atomic<bool> running{true};
+    };
+
+    static asio::awaitable<void> check_loop(std::shared_ptr<State> state) {
+        asio::steady_timer timer(state->strand);
+        state->timer = &timer;
+        while (state->running) {
+            timer.expires_after(state->options.check_interval);
+            boost::system::error_code ec;
+            co_await timer.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+            if (state->running) {
+                state->check();
+            }
+        }
+        state->timer = nullptr;
+    }
+
+    std::shared_ptr<State> state_;
+};
+
+} // namespace cpp_log
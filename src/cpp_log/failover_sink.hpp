@@ -0,0 +1,285 @@
+#pragma once
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "cpp_log/async_sink.hpp"
+#include "cpp_log/backend.hpp"
+#include "cpp_log/metrics.hpp"
+#include "cpp_log/sink.hpp"
+
+namespace cpp_log {
+
+namespace asio = boost::asio;
+
+// 故障转移配置
+struct FailoverOptions {
+    std::string name = "failover";  // 指标名前缀
+    std::chrono::milliseconds latency_threshold{100};  // 当前目标最早一条未写出日志等待超过该时间视为故障
+    std::chrono::milliseconds check_interval{10};      // 后台检查当前目标积压和写入结果的间隔
+    std::chrono::milliseconds probe_interval{1000};    // 后台探测排在前面的目标的间隔
+    size_t queue_capacity = 8192;  // 每个目标的队列容量，队列满时立即切换到下一个目标
+    bool flush_each_write = false; // 每条日志后刷新，写入失败时只需补写出错的那一条
+};
+
+// 故障转移输出
+// 按顺序持有多个输出目标，每个目标由一条独立线程上的异步通道写出，生产者只入队，
+// 卡住的目标不会阻塞生产者。后台检查当前目标：写入失败、积压超过latency_threshold或
+// 队列已满时切换到下一个目标，写入失败的日志补写到下一个目标（按批刷新时整批补写，可能重复）。
+// 后台定期在排在前面的目标自己的通道上探测：写入失败的先recover()，再计时一次刷新，
+// 刷新耗时低于阈值且之前积压的日志已经写完才切换回去。每次切换都计入指标计数器：
+// <name>.failovers、<name>.recoveries
+class FailoverSink : public LogSink {
+public:
+    FailoverSink(std::vector<std::shared_ptr<LogSink>> targets,
+                 FailoverOptions options = {})
+        : FailoverSink(std::move(targets), std::move(options), LogBackend::instance().get_io_context()) {}
+
+    FailoverSink(std::vector<std::shared_ptr<LogSink>> targets,
+                 FailoverOptions options,
+                 asio::io_context& ioc)
+        : state_(std::make_shared<State>(std::move(options))) {
+        if (targets.empty()) {
+            throw std::invalid_argument("FailoverSink requires at least one target");
+        }
+        for (size_t i = 0; i < targets.size(); ++i) {
+            state_->lanes.push_back(std::make_shared<Lane>(*state_, i, std::move(targets[i])));
+        }
+        asio::co_spawn(ioc, monitor_loop(state_), asio::detached);
+    }
+
+    // 按顺序停止各目标的通道并写完积压，目标在调用线程上析构，不会留给后台协程
+    // 前面的通道补写时只会写到后面的通道，所以后面的通道仍然可用
+    ~FailoverSink() override {
+        state_->running = false;
+        for (auto& slot : state_->lanes) {
+            std::shared_ptr<Lane> lane;
+            {
+                std::lock_guard<std::mutex> lock(state_->mutex);
+                lane = std::move(slot);
+            }
+            lane.reset();
+        }
+    }
+
+    void write(const LogContext& context) override {
+        if (!should_log(context.level)) {
+            return;
+        }
+        write_record(LogRecord::create(context));
+    }
+
+    void write_record(const RecordPtr& record) override {
+        if (!should_log(record->context().level)) {
+            return;
+        }
+        state_->route(state_->active.load(std::memory_order_acquire), record);
+    }
+
+    // 写出并刷新当前目标通道中已提交的日志；刷新失败时补写到后面的目标，所以后面的通道也依次刷新
+    // 当前目标卡住时与AsyncLogSink::flush一样，长时间没有进展就放弃等待
+    void flush() override {
+        for (size_t i = state_->active.load(std::memory_order_acquire); i < state_->lanes.size(); ++i) {
+            state_->lanes[i]->flush();
+        }
+    }
+
+    bool healthy() const override {
+        return state_->active_lane().healthy();
+    }
+
+    double pressure() const override {
+        return state_->active_lane().pressure();
+    }
+
+    // 写入经由各目标的异步通道
+    bool asynchronous() const override {
+        return true;
+    }
+
+    // 当前正在使用的目标索引
+    size_t active_index() const {
+        return state_->active.load(std::memory_order_acquire);
+    }
+
+private:
+    class Lane;
+
+    // 与后台检查协程共享的状态，sink析构后由协程持有直到退出
+    // 析构函数先清空lanes，协程只在持有mutex时访问lanes，不会成为目标的最后持有者
+    struct State {
+        explicit State(FailoverOptions options_)
+            : options(std::move(options_))
+            , failovers(Metrics::instance().shared_counter(options.name + ".failovers"))
+            , recoveries(Metrics::instance().shared_counter(options.name + ".recoveries")) {}
+
+        Lane& active_lane() const {
+            return *lanes[active.load(std::memory_order_acquire)];
+        }
+
+        // 从index开始找一个队列未满的目标写入，都满时交给最后一个目标按DropNewest丢弃
+        void route(size_t index, const RecordPtr& record) {
+            while (lanes[index]->pressure() >= 1.0 && fail_over(index)) {
+                ++index;
+            }
+            lanes[index]->write_record(record);
+        }
+
+        // 从index切换到下一个目标，已经是最后一个时返回false
+        bool fail_over(size_t index) {
+            if (index + 1 >= lanes.size()) {
+                return false;
+            }
+            size_t expected = index;
+            if (active.compare_exchange_strong(expected, index + 1, std::memory_order_acq_rel)) {
+                failovers->add();
+            }
+            return true;
+        }
+
+        // 在后台持有mutex时调用：当前目标出错或积压过久时切换，probe为true时探测前面的目标
+        void check(bool probe) {
+            size_t index = active.load(std::memory_order_acquire);
+            auto& lane = *lanes[index];
+            if (!lane.healthy() || lane.lag() > options.latency_threshold) {
+                fail_over(index);
+            }
+            if (!probe) {
+                return;
+            }
+            for (size_t i = 0; i < index; ++i) {
+                auto& candidate = *lanes[i];
+                if (candidate.take_probe_result() && candidate.pending() == 0) {
+                    active.store(i, std::memory_order_release);
+                    recoveries->add();
+                    break;
+                }
+                candidate.probe();
+            }
+        }
+
+        FailoverOptions options;
+        std::vector<std::shared_ptr<Lane>> lanes;
+        std::atomic<size_t> active{0};
+        std::atomic<bool> running{true};
+        std::mutex mutex;
+        // 共享所有权，计数器被Metrics::remove移除之后仍然可以使用
+        std::shared_ptr<Counter> failovers;
+        std::shared_ptr<Counter> recoveries;
+    };
+
+    // 一个目标的异步通道，写入、刷新、recover()和探测都在通道自己的线程上串行执行
+    class Lane : public AsyncSinkAdapter {
+    public:
+        Lane(State& state, size_t index, std::shared_ptr<LogSink> target)
+            : AsyncSinkAdapter(dedicated_executor, std::move(target))
+            , state_(state)
+            , index_(index) {
+            set_capacity(state.options.queue_capacity);
+            set_overflow_policy(OverflowPolicy::DropNewest);
+            set_flush_policy(state.options.flush_each_write ? FlushPolicy::EveryRecord : FlushPolicy::EveryBatch);
+            set_wait_strategy(WaitStrategy::Block);
+        }
+
+        ~Lane() override {
+            shutdown();
+        }
+
+        // 最近一次刷新后目标是否正常
+        bool healthy() const override {
+            return healthy_.load(std::memory_order_acquire);
+        }
+
+        // 在通道线程上探测目标，结果由下一次take_probe_result取出
+        // 目标卡住时探测排在积压的日志之后，一直不会有结果
+        void probe() {
+            run_on_strand([this]() {
+                auto& target = *sink();
+                bool ok = target.healthy() || target.recover();
+                auto start = std::chrono::steady_clock::now();
+                target.flush();
+                auto elapsed = std::chrono::steady_clock::now() - start;
+                bool good = target.healthy();
+                healthy_.store(good, std::memory_order_release);
+                probe_ok_.store(ok && good && elapsed < state_.options.latency_threshold,
+                                std::memory_order_release);
+            });
+        }
+
+        bool take_probe_result() {
+            return probe_ok_.exchange(false, std::memory_order_acq_rel);
+        }
+
+    protected:
+        asio::awaitable<void> do_write_record(const RecordPtr& record) override {
+            unflushed_.push_back(record);
+            co_await AsyncSinkAdapter::do_write_record(record);
+        }
+
+        asio::awaitable<void> do_write_batch(std::span<const RecordPtr> records) override {
+            unflushed_.insert(unflushed_.end(), records.begin(), records.end());
+            co_await AsyncSinkAdapter::do_write_batch(records);
+        }
+
+        // 缓冲的写入错误在刷新时才暴露，刷新后仍不正常就把上次刷新以来的日志补写到下一个目标
+        asio::awaitable<void> do_flush() override {
+            co_await AsyncSinkAdapter::do_flush();
+            bool good = sink()->healthy();
+            healthy_.store(good, std::memory_order_release);
+            if (!good && state_.fail_over(index_)) {
+                for (const auto& record : unflushed_) {
+                    state_.route(index_ + 1, record);
+                }
+            }
+            unflushed_.clear();
+        }
+
+    private:
+        State& state_;
+        size_t index_;
+        std::vector<RecordPtr> unflushed_;  // 上次刷新以来写出的日志，只在通道线程上访问
+        std::atomic<bool> healthy_{true};
+        std::atomic<bool> probe_ok_{false};
+    };
+
+    static asio::awaitable<void> monitor_loop(std::shared_ptr<State> state) {
+        asio::steady_timer timer(co_await asio::this_coro::executor);
+        auto next_probe = std::chrono::steady_clock::now() + state->options.probe_interval;
+        while (state->running) {
+            timer.expires_after(state->options.check_interval);
+            // 与AggregatingSink::report_loop相同，定时器被取消时不抛出异常，直接退出
+            boost::system::error_code ec;
+            co_await timer.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+            if (ec == asio::error::operation_aborted) {
+                break;
+            }
+
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (!state->running) {
+                break;
+            }
+            auto now = std::chrono::steady_clock::now();
+            bool probe = now >= next_probe;
+            if (probe) {
+                next_probe = now + state->options.probe_interval;
+            }
+            state->check(probe);
+        }
+    }
+
+    std::shared_ptr<State> state_;
+};
+
+} // namespace cpp_log
@@ -0,0 +1,256 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace cpp_log {
+
+// 结构化字段的值类型
+enum class FieldType : std::uint8_t {
+    Bool,
+    Int,
+    UInt,
+    Double,
+    String
+};
+
+// 一个结构化字段
+// 作为kv()的返回值时key和字符串值引用调用方的数据，只在这一次日志调用中有效；
+// 从FieldList中读出时引用记录内部的缓冲区
+struct Field {
+    std::string_view key;
+    FieldType type = FieldType::Int;
+    std::uint64_t bits = 0;  // 数值类型的二进制表示
+    std::string_view text;   // 字符串类型的值
+
+    bool as_bool() const { return bits != 0; }
+    std::int64_t as_int() const { return static_cast<std::int64_t>(bits); }
+    std::uint64_t as_uint() const { return bits; }
+    double as_double() const { return std::bit_cast<double>(bits); }
+    std::string_view as_string() const { return text; }
+};
+
+// 构造一个结构化字段，值保持原本的类型，不会先格式化成文本
+// char作为一个字符的字符串，引用调用方的变量；signed char和unsigned char仍按整数处理
+template<typename T>
+Field kv(std::string_view key, const T& value) {
+    if constexpr (std::is_same_v<T, bool>) {
+        return {key, FieldType::Bool, value ? 1u : 0u, {}};
+    } else if constexpr (std::is_same_v<T, char>) {
+        return {key, FieldType::String, 0, std::string_view(&value, 1)};
+    } else if constexpr (std::is_enum_v<T>) {
+        return kv(key, static_cast<std::underlying_type_t<T>>(value));
+    } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        return {key, FieldType::Int, static_cast<std::uint64_t>(static_cast<std::int64_t>(value)), {}};
+    } else if constexpr (std::is_integral_v<T>) {
+        return {key, FieldType::UInt, static_cast<std::uint64_t>(value), {}};
+    } else if constexpr (std::is_floating_point_v<T>) {
+        return {key, FieldType::Double, std::bit_cast<std::uint64_t>(static_cast<double>(value)), {}};
+    } else {
+        static_assert(std::is_convertible_v<const T&, std::string_view>,
+                      "kv() supports bool, integers, enums, floating point and strings");
+        return {key, FieldType::String, 0, std::string_view(value)};
+    }
+}
+
+// 日志记录中的结构化字段，按顺序编码在一块连续的缓冲区里：
+// [类型 1字节][key长度 2字节][key][值]，数值占8字节，bool占1字节，字符串为[长度 4字节][内容]
+class FieldList {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Field;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Field*;
+        using reference = const Field&;
+
+        iterator() = default;
+
+        const Field& operator*() const { return field_; }
+        const Field* operator->() const { return &field_; }
+
+        iterator& operator++() {
+            pos_ = next_;
+            decode();
+            return *this;
+        }
+
+        iterator operator++(int) {
+            auto copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        bool operator==(const iterator& other) const { return pos_ == other.pos_; }
+
+    private:
+        friend class FieldList;
+
+        iterator(std::string_view bytes, size_t pos) : bytes_(bytes), pos_(pos) {
+            decode();
+        }
+
+        void decode() {
+            if (pos_ >= bytes_.size()) {
+                return;
+            }
+            size_t pos = pos_;
+            field_.type = static_cast<FieldType>(bytes_[pos++]);
+            auto key_length = read<std::uint16_t>(pos);
+            field_.key = bytes_.substr(pos, key_length);
+            pos += key_length;
+            field_.bits = 0;
+            field_.text = {};
+            switch (field_.type) {
+                case FieldType::Bool:
+                    field_.bits = static_cast<std::uint8_t>(bytes_[pos++]);
+                    break;
+                case FieldType::String: {
+                    auto length = read<std::uint32_t>(pos);
+                    field_.text = bytes_.substr(pos, length);
+                    pos += length;
+                    break;
+                }
+                default:
+                    field_.bits = read<std::uint64_t>(pos);
+                    break;
+            }
+            next_ = pos;
+        }
+
+        template<typename T>
+        T read(size_t& pos) const {
+            T value;
+            std::memcpy(&value, bytes_.data() + pos, sizeof(T));
+            pos += sizeof(T);
+            return value;
+        }
+
+        std::string_view bytes_;
+        size_t pos_ = 0;
+        size_t next_ = 0;
+        Field field_;
+    };
+
+    void append(const Field& field) {
+        auto key = field.key.substr(0, UINT16_MAX);
+        bytes_ += static_cast<char>(field.type);
+        write(static_cast<std::uint16_t>(key.size()));
+        bytes_ += key;
+        switch (field.type) {
+            case FieldType::Bool:
+                bytes_ += static_cast<char>(field.bits != 0);
+                break;
+            case FieldType::String: {
+                auto text = field.text.substr(0, UINT32_MAX);
+                write(static_cast<std::uint32_t>(text.size()));
+                bytes_ += text;
+                break;
+            }
+            default:
+                write(field.bits);
+                break;
+        }
+    }
+
+    void assign(const FieldList& other) { bytes_.assign(other.bytes_); }
+    void clear() { bytes_.clear(); }
+    bool empty() const { return bytes_.empty(); }
+
+    // 编码后的原始字节，二进制sink可以直接保存
+    std::string_view bytes() const { return bytes_; }
+
+    iterator begin() const { return iterator(bytes_, 0); }
+    iterator end() const { return iterator(bytes_, bytes_.size()); }
+
+private:
+    template<typename T>
+    void write(T value) {
+        char buffer[sizeof(T)];
+        std::memcpy(buffer, &value, sizeof(T));
+        bytes_.append(buffer, sizeof(T));
+    }
+
+    std::string bytes_;
+};
+
+// 把字段的值以文本形式追加到out，字符串原样追加
+inline void append_field_value(std::string& out, const Field& field) {
+    switch (field.type) {
+        case FieldType::Bool:
+            out += field.as_bool() ? "true" : "false";
+            break;
+        case FieldType::Int:
+            std::format_to(std::back_inserter(out), "{}", field.as_int());
+            break;
+        case FieldType::UInt:
+            std::format_to(std::back_inserter(out), "{}", field.as_uint());
+            break;
+        case FieldType::Double:
+            std::format_to(std::back_inserter(out), "{}", field.as_double());
+            break;
+        case FieldType::String:
+            out += field.as_string();
+            break;
+    }
+}
+
+// 以logfmt格式追加所有字段：key=value，字段之间用空格分隔，
+// 字符串为空或者含有空格、等号、引号、控制字符时加引号并转义，
+// \n、\r、\t之外的控制字符写成\u00XX
+inline void append_logfmt(std::string& out, const FieldList& fields) {
+    bool first = true;
+    for (const auto& field : fields) {
+        if (!first) {
+            out += ' ';
+        }
+        first = false;
+        out += field.key;
+        out += '=';
+        if (field.type != FieldType::String) {
+            append_field_value(out, field);
+            continue;
+        }
+        auto text = field.as_string();
+        bool quote = text.empty() || text.find_first_of(" =\"\\") != std::string_view::npos ||
+            std::any_of(text.begin(), text.end(), [](char c) { return static_cast<unsigned char>(c) < 0x20; });
+        if (!quote) {
+            out += text;
+            continue;
+        }
+        out += '"';
+        for (char c : text) {
+            switch (c) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        std::format_to(std::back_inserter(out), "\\u{:04x}", static_cast<unsigned>(c));
+                    } else {
+                        out += c;
+                    }
+                    break;
+            }
+        }
+        out += '"';
+    }
+}
+
+inline std::string to_logfmt(const FieldList& fields) {
+    std::string out;
+    append_logfmt(out, fields);
+    return out;
+}
+
+} // namespace cpp_log
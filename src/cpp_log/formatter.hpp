@@ -1,11 +1,19 @@
 #pragma once
 
+#include <memory>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <cstdint>
 #include <chrono>
 #include <format>
+#include <iterator>
+#include <source_location>
 #include <sstream>
 #include "cpp_log/level.hpp"
 #include "cpp_log/color.hpp"
+#include "cpp_log/mdc.hpp"
+#include "cpp_log/fields.hpp"
 
 // 为 std::thread::id 添加格式化支持
 template<>
@@ -26,6 +34,10 @@ struct LogContext {
     std::source_location location;
     std::thread::id thread_id;
     std::string message;
+    std::uint64_t sequence = 0;  // 进程内唯一、同一线程内递增的记录序号
+    MdcSnapshot mdc;             // 记录创建时线程的诊断上下文
+    FieldList fields;            // 结构化字段，保持原本的类型
+    std::chrono::nanoseconds elapsed{0};  // 计时日志的耗时，记录时间为计时结束的时刻，0表示普通日志
 };
 
 // 日志格式化器接口
@@ -33,25 +45,66 @@ class LogFormatter {
 public:
     virtual ~LogFormatter() = default;
     virtual std::string format(const LogContext& context) = 0;
+
+    // 把格式化结果追加到out，派生类可以直接写入调用方的缓冲区而不生成临时字符串
+    virtual void format_to(const LogContext& context, std::string& out) {
+        out += format(context);
+    }
+
+    // 输出是否为二进制，二进制输出不能去除颜色代码
+    virtual bool binary() const {
+        return false;
+    }
 };
 
+namespace detail {
+    // 线程ID的文本形式，同一线程连续的日志复用上一次的结果
+    inline const std::string& thread_id_text(std::thread::id id) {
+        thread_local std::thread::id cached_id;
+        thread_local std::string cached_text;
+        if (id != cached_id || cached_text.empty()) {
+            cached_id = id;
+            cached_text = std::format("{}", id);
+        }
+        return cached_text;
+    }
+} // namespace detail
+
 // 默认格式化器
 class DefaultFormatter : public LogFormatter {
 public:
     std::string format(const LogContext& context) override {
-        auto time_str = std::format("{:%Y-%m-%d %H:%M:%S}", context.timestamp);
+        std::string out;
+        format_to(context, out);
+        return out;
+    }
+
+    // 直接追加到out，不生成中间字符串
+    void format_to(const LogContext& context, std::string& out) override {
         auto level_color = get_level_color(context.level);
-        
-        return std::format("{}{}{} {}[{}]{} {}{}<{}:{}>{}{}(Thread {}){}{}{}{}",
-            color::cyan, time_str, color::reset,
+        std::format_to(std::back_inserter(out), "{}{:%Y-%m-%d %H:%M:%S}{} {}[{}]{} {}{}<{}:{}>{}{}(Thread {}){}{}",
+            color::cyan, context.timestamp, color::reset,
             level_color, get_level_string(context.level), color::reset,
             color::blue, context.location.file_name(), context.location.line(), color::reset,
             color::magenta, context.thread_id, color::reset,
-            level_color, context.message, color::reset,
-            "\n");
+            level_color, context.message);
+        // 结构化字段以logfmt形式跟在消息后面
+        if (!context.fields.empty()) {
+            out += ' ';
+            append_logfmt(out, context.fields);
+        }
+        out += color::reset;
+        out += '\n';
     }
 };
 
+// 进程内共享的默认格式化器
+// 默认格式化器没有状态，各个sink共用同一个实例，同一条记录在这些sink之间只格式化一次
+inline std::shared_ptr<LogFormatter> shared_default_formatter() {
+    static std::shared_ptr<LogFormatter> formatter = std::make_shared<DefaultFormatter>();
+    return formatter;
+}
+
 // 自定义格式化器
 class PatternFormatter : public LogFormatter {
 public:
@@ -62,58 +115,98 @@ public:
     // %n - 行号
     // %d - 线程ID
     // %m - 日志消息
+    // %q - 记录序号
+    // %X - 诊断上下文的全部键值，形如 key=value key=value
+    // %X{key} - 诊断上下文中key的值，不存在时为空
+    // %k - 结构化字段，logfmt格式
     // %% - % 字符
     explicit PatternFormatter(std::string pattern) : pattern_(std::move(pattern)) {}
 
     std::string format(const LogContext& context) override {
-        std::string result = pattern_;
-        auto time_str = std::format("{:%Y-%m-%d %H:%M:%S}", context.timestamp);
+        std::string out;
+        format_to(context, out);
+        return out;
+    }
 
-        // 替换所有的占位符
+    // 扫描模式串，字面文本和占位符的值依次追加到out，不生成中间字符串
+    // 占位符的值不会再被当作模式解析
+    void format_to(const LogContext& context, std::string& out) override {
+        std::string_view pattern = pattern_;
+        size_t start = 0;  // 尚未输出的字面文本的起点
         size_t pos = 0;
-        while ((pos = result.find('%', pos)) != std::string::npos) {
-            if (pos + 1 >= result.length()) break;
+        while ((pos = pattern.find('%', pos)) != std::string_view::npos) {
+            if (pos + 1 >= pattern.size()) break;
 
-            char specifier = result[pos + 1];
-            std::string replacement;
+            char specifier = pattern[pos + 1];
+            size_t length = 2;
+            // 确认是占位符之后再输出前面的字面文本
+            auto literal = [&] { out.append(pattern, start, pos - start); };
 
             switch (specifier) {
                 case 't': // 时间戳
-                    replacement = time_str;
+                    literal();
+                    std::format_to(std::back_inserter(out), "{:%Y-%m-%d %H:%M:%S}", context.timestamp);
                     break;
                 case 'l': // 日志级别
-                    replacement = std::string(get_level_string(context.level));
+                    literal();
+                    out += get_level_string(context.level);
                     break;
                 case 'f': // 文件名
-                    replacement = context.location.file_name();
+                    literal();
+                    out += context.location.file_name();
                     break;
                 case 'n': // 行号
-                    replacement = std::to_string(context.location.line());
+                    literal();
+                    std::format_to(std::back_inserter(out), "{}", context.location.line());
                     break;
                 case 'd': // 线程ID
-                    {
-                        std::stringstream ss;
-                        ss << context.thread_id;
-                        replacement = ss.str();
-                    }
+                    literal();
+                    out += detail::thread_id_text(context.thread_id);
                     break;
                 case 'm': // 消息
-                    replacement = context.message;
+                    literal();
+                    out += context.message;
+                    break;
+                case 'q': // 序号
+                    literal();
+                    std::format_to(std::back_inserter(out), "{}", context.sequence);
+                    break;
+                case 'k': // 结构化字段
+                    literal();
+                    append_logfmt(out, context.fields);
+                    break;
+                case 'X': // 诊断上下文
+                    if (pos + 2 < pattern.size() && pattern[pos + 2] == '{') {
+                        size_t close = pattern.find('}', pos + 3);
+                        if (close == std::string_view::npos) {
+                            pos++;
+                            continue;
+                        }
+                        literal();
+                        if (auto* value = mdc_find(context.mdc, pattern.substr(pos + 3, close - pos - 3))) {
+                            append_mdc_value(out, *value);
+                        }
+                        length = close - pos + 1;
+                    } else {
+                        literal();
+                        out += mdc_to_string(context.mdc);
+                    }
                     break;
                 case '%': // 转义 %
-                    replacement = "%";
+                    literal();
+                    out += '%';
                     break;
                 default:
                     pos++;
                     continue;
             }
 
-            result.replace(pos, 2, replacement);
-            pos += replacement.length();
+            pos += length;
+            start = pos;
         }
 
-        result += '\n';
-        return result;
+        out.append(pattern, start, std::string_view::npos);
+        out += '\n';
     }
 
 private:
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include "cpp_log/level.hpp"
+#include "cpp_log/formatter.hpp"
+#include "cpp_log/fields.hpp"
+#include "cpp_log/mdc.hpp"
+
+// 定义CPP_LOG_NO_SSE2时总是使用逐字节查表的实现
+#if !defined(CPP_LOG_NO_SSE2) && \
+    (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define CPP_LOG_JSON_SSE2 1
+#endif
+
+namespace cpp_log {
+
+namespace detail {
+
+// JSON字符串转义表：0表示原样输出，'u'表示输出\u00XX，其他值是反斜杠后面的字符
+inline constexpr std::array<char, 256> json_escape_table = [] {
+    std::array<char, 256> table{};
+    for (int c = 0; c < 0x20; ++c) {
+        table[c] = 'u';
+    }
+    table['\b'] = 'b';
+    table['\f'] = 'f';
+    table['\n'] = 'n';
+    table['\r'] = 'r';
+    table['\t'] = 't';
+    table['"'] = '"';
+    table['\\'] = '\\';
+    return table;
+}();
+
+// 从text开头开始的一个UTF-8字符的长度，不是合法的UTF-8序列时返回0
+inline size_t utf8_sequence_length(std::string_view text) {
+    auto byte = [&](size_t i) { return static_cast<unsigned char>(text[i]); };
+    auto continuation = [&](size_t i) { return i < text.size() && (byte(i) & 0xC0) == 0x80; };
+
+    unsigned char lead = byte(0);
+    if (lead < 0x80) {
+        return 1;
+    }
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        return continuation(1) ? 2 : 0;
+    }
+    if (lead >= 0xE0 && lead <= 0xEF) {
+        if (!continuation(1) || !continuation(2)) {
+            return 0;
+        }
+        // 排除过长编码和代理区
+        if ((lead == 0xE0 && byte(1) < 0xA0) || (lead == 0xED && byte(1) > 0x9F)) {
+            return 0;
+        }
+        return 3;
+    }
+    if (lead >= 0xF0 && lead <= 0xF4) {
+        if (!continuation(1) || !continuation(2) || !continuation(3)) {
+            return 0;
+        }
+        if ((lead == 0xF0 && byte(1) < 0x90) || (lead == 0xF4 && byte(1) > 0x8F)) {
+            return 0;
+        }
+        return 4;
+    }
+    return 0;
+}
+
+// 处理一个需要转义或者不是ASCII的字节，返回消耗的字节数
+inline size_t append_json_special(std::string& out, std::string_view text) {
+    unsigned char c = static_cast<unsigned char>(text[0]);
+    if (c < 0x80) {
+        char escape = json_escape_table[c];
+        out += '\\';
+        out += escape;
+        if (escape == 'u') {
+            static constexpr char hex[] = "0123456789abcdef";
+            out += "00";
+            out += hex[c >> 4];
+            out += hex[c & 0xF];
+        }
+        return 1;
+    }
+    size_t length = utf8_sequence_length(text);
+    if (length == 0) {
+        out += "\\ufffd";  // 非法的UTF-8字节替换为U+FFFD，保证输出是合法的JSON
+        return 1;
+    }
+    out.append(text.data(), length);
+    return length;
+}
+
+// 以JSON字符串的形式追加text（含两端引号），直接写入out
+// 大段不需要转义的ASCII文本用SSE2每次检查16字节，其余情况逐字节查表
+inline void append_json_string(std::string& out, std::string_view text) {
+    out += '"';
+    size_t pos = 0;
+    size_t size = text.size();
+    while (pos < size) {
+        size_t start = pos;
+#ifdef CPP_LOG_JSON_SSE2
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i control = _mm_set1_epi8(0x1F);
+        while (pos + 16 <= size) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + pos));
+            // 小于等于0x1F：与0x1F取无符号最大值后仍等于0x1F
+            __m128i special = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+            // 最高位为1的字节不是ASCII，交给逐字节的UTF-8检查
+            int mask = _mm_movemask_epi8(special) | _mm_movemask_epi8(chunk);
+            if (mask != 0) {
+                pos += static_cast<size_t>(std::countr_zero(static_cast<unsigned>(mask)));
+                break;
+            }
+            pos += 16;
+        }
+#endif
+        while (pos < size) {
+            unsigned char c = static_cast<unsigned char>(text[pos]);
+            if (c >= 0x80 || json_escape_table[c] != 0) {
+                break;
+            }
+            ++pos;
+        }
+        out.append(text.data() + start, pos - start);
+        if (pos < size) {
+            unsigned char c = static_cast<unsigned char>(text[pos]);
+            if (c >= 0x80 || json_escape_table[c] != 0) {
+                pos += append_json_special(out, text.substr(pos));
+            }
+        }
+    }
+    out += '"';
+}
+
+// 以JSON值的形式追加一个结构化字段的值，NaN和无穷大输出为null
+inline void append_json_value(std::string& out, const Field& field) {
+    switch (field.type) {
+        case FieldType::String:
+            append_json_string(out, field.as_string());
+            break;
+        case FieldType::Double:
+            if (!std::isfinite(field.as_double())) {
+                out += "null";
+                break;
+            }
+            [[fallthrough]];
+        default:
+            append_field_value(out, field);
+            break;
+    }
+}
+
+// 以JSON字符串的形式追加诊断上下文的值，数值类型在这里才转换成文本
+// 数值的文本不含需要转义的字符，直接加上引号
+inline void append_json_mdc_value(std::string& out, const MdcValue& value) {
+    if (value.type == FieldType::String) {
+        append_json_string(out, value.text);
+        return;
+    }
+    out += '"';
+    append_mdc_value(out, value);
+    out += '"';
+}
+
+} // namespace detail
+
+// JSON Lines格式化器
+// 每条日志输出一个JSON对象并以换行结束：
+// {"ts":"2024-01-01T00:00:00.000000Z","level":"INFO","file":"main.cpp","line":12,
+//  "thread":"140245","seq":7,"msg":"...","mdc":{...},"fields":{...}}
+// mdc和fields只在非空时输出，时间为UTC，非法的UTF-8字节替换为U+FFFD
+class JsonFormatter : public LogFormatter {
+public:
+    std::string format(const LogContext& context) override {
+        std::string out;
+        out.reserve(160 + context.message.size() + context.fields.bytes().size());
+        format_to(context, out);
+        return out;
+    }
+
+    void format_to(const LogContext& context, std::string& out) override {
+
+        // 同一秒内的日志复用已经格式化好的日期时间
+        thread_local std::chrono::sys_seconds cached_seconds{};
+        thread_local std::string cached_time;
+
+        auto seconds = std::chrono::floor<std::chrono::seconds>(context.timestamp);
+        if (seconds != cached_seconds || cached_time.empty()) {
+            cached_seconds = seconds;
+            cached_time = std::format("{:%Y-%m-%dT%H:%M:%S}", seconds);
+        }
+        auto micros = std::chrono::duration_cast<std::chrono::microseconds>(context.timestamp - seconds).count();
+
+        out += "{\"ts\":\"";
+        out += cached_time;
+        std::format_to(std::back_inserter(out), ".{:06}Z\",\"level\":\"", micros);
+        out += get_level_string(context.level);
+        out += "\",\"file\":";
+        detail::append_json_string(out, context.location.file_name());
+        std::format_to(std::back_inserter(out), ",\"line\":{},\"thread\":\"", context.location.line());
+        out += detail::thread_id_text(context.thread_id);
+        std::format_to(std::back_inserter(out), "\",\"seq\":{},\"msg\":", context.sequence);
+        detail::append_json_string(out, context.message);
+
+        if (context.mdc) {
+            out += ",\"mdc\":{";
+            bool first = true;
+            for (const MdcFrame* frame = context.mdc.get(); frame; frame = frame->parent.get()) {
+                if (mdc_find(context.mdc, frame->key) != &frame->value) {
+                    continue;  // 被内层同名key覆盖
+                }
+                if (!first) {
+                    out += ',';
+                }
+                first = false;
+                detail::append_json_string(out, frame->key);
+                out += ':';
+                detail::append_json_mdc_value(out, frame->value);
+            }
+            out += '}';
+        }
+
+        if (!context.fields.empty()) {
+            out += ",\"fields\":{";
+            bool first = true;
+            for (const auto& field : context.fields) {
+                if (!first) {
+                    out += ',';
+                }
+                first = false;
+                detail::append_json_string(out, field.key);
+                out += ':';
+                detail::append_json_value(out, field);
+            }
+            out += '}';
+        }
+
+        out += "}\n";
+    }
+};
+
+} // namespace cpp_log
@@ -21,4 +21,14 @@ constexpr const char* get_level_string(Level level) {
     }
 }
 
+// 按负载（0到1）给出建议的最低等级，不低于level：负载达到0.5时至少为Info，
+// 达到0.8时至少为Warning，达到0.95时至少为Error；Logger和StaticLogger的pressure_level共用
+constexpr Level pressure_cutoff(Level level, double pressure) {
+    Level cutoff = pressure >= 0.95 ? Level::Error
+                 : pressure >= 0.8  ? Level::Warning
+                 : pressure >= 0.5  ? Level::Info
+                                    : Level::Debug;
+    return static_cast<int>(cutoff) > static_cast<int>(level) ? cutoff : level;
+}
+
 } // namespace cpp_log
\ No newline at end of file
@@ -12,45 +12,105 @@
 #include <vector>
 #include <memory>
 #include <optional>
+#include <span>
 
 #include<boost/asio/io_context.hpp>
 #include "cpp_log/level.hpp"
+#include "cpp_log/backend.hpp"
 #include "cpp_log/sink.hpp"
 #include "cpp_log/formatter.hpp"
+#include "cpp_log/record.hpp"
+#include "cpp_log/probes.hpp"
+#include "cpp_log/mdc.hpp"
+#include "cpp_log/fields.hpp"
+#include "cpp_log/json_formatter.hpp"
+#include "cpp_log/msgpack_formatter.hpp"
+#include "cpp_log/scope_timer.hpp"
+#include "cpp_log/trace_event_sink.hpp"
 #include "cpp_log/async_sink.hpp"
+#include "cpp_log/static_logger.hpp"
+#include "cpp_log/stall_detector.hpp"
+#include "cpp_log/failover_sink.hpp"
+#include "cpp_log/aggregating_sink.hpp"
+#include "cpp_log/parallel_format_sink.hpp"
+#include "cpp_log/threading.hpp"
+
+#if defined(_MSC_VER)
+#define CPP_LOG_NOINLINE __declspec(noinline)
+#elif defined(__GNUC__) || defined(__clang__)
+#define CPP_LOG_NOINLINE __attribute__((noinline))
+#else
+#define CPP_LOG_NOINLINE
+#endif
 
 namespace cpp_log {
 
 namespace asio = boost::asio;
 
-// 日志记录器类
-class Logger {
+// 日志记录器类，ThreadingPolicy决定使用真实的锁还是空锁
+template<typename ThreadingPolicy>
+class BasicLogger : public ForkHandler {
 public:
-    Logger(std::shared_ptr<asio::io_context> ioc = nullptr)
+    using mutex_type = typename ThreadingPolicy::mutex_type;
+
+    // 未指定io_context时使用进程级LogBackend的io_context
+    BasicLogger(std::shared_ptr<asio::io_context> ioc = nullptr)
         : min_level_(Level::Debug)
-        , io_context_(ioc ? ioc : std::make_shared<asio::io_context>()) {}
-    
-    ~Logger() = default;
+        , io_context_(ioc ? ioc : LogBackend::instance().io_context_ptr()) {
+        // 多线程版本在fork前持有锁，避免子进程继承一把被其他线程占用的锁
+        if constexpr (!std::is_same_v<ThreadingPolicy, SingleThreaded>) {
+            LogBackend::instance().add_fork_handler(this);
+        }
+    }
+
+    ~BasicLogger() override {
+        if constexpr (!std::is_same_v<ThreadingPolicy, SingleThreaded>) {
+            LogBackend::instance().remove_fork_handler(this);
+        }
+    }
+
+    void prepare_fork() override { mutex_.lock(); }
+    void after_fork_parent() override { mutex_.unlock(); }
+    void after_fork_child() override { mutex_.unlock(); }
+    ForkStage fork_stage() const override { return ForkStage::Lock; }
+
+    // 单线程版本在Debug模式下检查只有所有者线程在使用，默认第一次加锁（包括add_sink）的线程成为所有者。
+    // 在一个线程上创建和配置、交给另一个线程使用时，在使用的线程上调用一次；多线程版本什么也不做
+    void bind_to_current_thread() {
+        if constexpr (std::is_same_v<ThreadingPolicy, SingleThreaded>) {
+            mutex_.bind_to_current_thread();
+        }
+    }
 
     // 获取io_context
     asio::io_context& get_io_context() { return *io_context_; }
 
     // 添加输出目标，返回sink的索引
     size_t add_sink(std::shared_ptr<LogSink> sink) {
-        std::lock_guard<std::mutex> lock(mutex_);
+        std::lock_guard<mutex_type> lock(mutex_);
+        if constexpr (is_single_threaded) {
+            if (sink->asynchronous()) {
+                fork_gate_.set_enabled(true);
+            }
+        }
         sinks_.push_back(std::move(sink));
+        publish_sinks();
         return sinks_.size() - 1;
     }
 
     // 清除所有输出目标
     void clear_sinks() {
-        std::lock_guard<std::mutex> lock(mutex_);
+        std::lock_guard<mutex_type> lock(mutex_);
         sinks_.clear();
+        if constexpr (is_single_threaded) {
+            fork_gate_.set_enabled(false);
+        }
+        publish_sinks();
     }
 
     // 根据索引获取输出对象
     std::shared_ptr<LogSink> get_sink(size_t index) {
-        std::lock_guard<std::mutex> lock(mutex_);
+        std::lock_guard<mutex_type> lock(mutex_);
         if (index < sinks_.size()) {
             return sinks_[index];
         }
@@ -59,19 +119,36 @@ public:
 
     // 设置全局最小日志等级
     void set_level(Level level) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        min_level_ = level;
+        min_level_.store(level, std::memory_order_relaxed);
     }
 
     // 获取全局最小日志等级
     Level level() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return min_level_;
-    }// 检查是否应该记录该等级的日志
+        return min_level_.load(std::memory_order_relaxed);
+    }// 检查是否应该记录该等级的日志，不需要加锁
     bool should_log(Level level) const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return level >= min_level_;
-    }template<typename... Args>
+        return level >= min_level_.load(std::memory_order_relaxed);
+    }
+
+    // 所有输出目标中最高的负载（队列填充比例，0到1），用于在构建开销大的调试信息之前
+    // 判断输出是否已经接近满载；各sink只读取原子计数器，结果是近似值
+    // 读取add_sink/clear_sinks发布的sink列表快照，不获取分发期间一直持有的mutex_；
+    // libstdc++的std::atomic<std::shared_ptr>内部仍有一把只在复制指针期间持有的锁
+    double pressure() const {
+        auto sinks = sinks_snapshot_.load(std::memory_order_acquire);
+        double result = 0.0;
+        for (const auto& sink : *sinks) {
+            result = std::max(result, sink->pressure());
+        }
+        return result;
+    }
+
+    // 按当前负载建议的最低等级，见pressure_cutoff
+    Level pressure_level() const {
+        return pressure_cutoff(level(), pressure());
+    }
+
+    template<typename... Args>
     void log(Level level,
              const std::source_location& location,
              std::format_string<Args...> fmt,
@@ -81,20 +158,61 @@ public:
             return;
         }
 
-        // 构建日志上下文
-        LogContext context{
-            .level = level,
-            .timestamp = std::chrono::system_clock::now(),
-            .location = location,
-            .thread_id = std::this_thread::get_id(),
-            .message = std::format(fmt, std::forward<Args>(args)...)
-        };
-        
-        std::lock_guard<std::mutex> lock(mutex_);
-        // 写入所有输出目标
-        for (auto& sink : sinks_) {
-            sink->write(context);
+        // 模板部分只负责打包参数，格式化和分发都交给非模板的vlog
+        vlog(level, location, fmt.get(), std::make_format_args(args...));
+    }
+
+    // 类型擦除后的日志入口，所有参数组合共用同一份代码
+    void vlog(Level level,
+              const std::source_location& location,
+              std::string_view fmt,
+              std::format_args args);
+
+    // 结构化日志：消息不经过格式化，字段按原本的类型保存在记录中
+    // logger.info_kv(std::source_location::current(), "order filled", kv("qty", q), kv("px", p));
+    template<typename... Fields>
+    void log_kv(Level level,
+                const std::source_location& location,
+                std::string_view message,
+                const Fields&... fields) {
+        if (!should_log(level)) {
+            return;
         }
+
+        const Field array[] = {Field{}, fields...};
+        vlog_kv(level, location, message, std::span<const Field>(array).subspan(1));
+    }
+
+    // elapsed非0时输出的是一条计时日志，见ScopeTimer
+    void vlog_kv(Level level,
+                 const std::source_location& location,
+                 std::string_view message,
+                 std::span<const Field> fields,
+                 std::chrono::nanoseconds elapsed = std::chrono::nanoseconds::zero());
+
+    template<typename... Fields>
+    void debug_kv(const std::source_location& location, std::string_view message, const Fields&... fields) {
+        log_kv(Level::Debug, location, message, fields...);
+    }
+
+    template<typename... Fields>
+    void info_kv(const std::source_location& location, std::string_view message, const Fields&... fields) {
+        log_kv(Level::Info, location, message, fields...);
+    }
+
+    template<typename... Fields>
+    void warn_kv(const std::source_location& location, std::string_view message, const Fields&... fields) {
+        log_kv(Level::Warning, location, message, fields...);
+    }
+
+    template<typename... Fields>
+    void error_kv(const std::source_location& location, std::string_view message, const Fields&... fields) {
+        log_kv(Level::Error, location, message, fields...);
+    }
+
+    template<typename... Fields>
+    void fatal_kv(const std::source_location& location, std::string_view message, const Fields&... fields) {
+        log_kv(Level::Fatal, location, message, fields...);
     }
 
     template<typename... Args>
@@ -125,12 +243,69 @@ public:
     }
 
 private:
-    mutable std::mutex mutex_;
+    // 把记录交给所有输出目标，fmt只用于USDT探针
+    // 单线程版本没有真实的锁，有异步sink时分发期间进入fork闸门
+    void dispatch(const RecordPtr& record, [[maybe_unused]] std::string_view fmt) {
+        std::optional<detail::ForkGateScope> gate;
+        if constexpr (is_single_threaded) {
+            if (fork_gate_.enabled()) {
+                gate.emplace(fork_gate_);
+            }
+        }
+        std::lock_guard<mutex_type> lock(mutex_);
+        for (auto& sink : sinks_) {
+            sink->write_record(record);
+        }
+        CPP_LOG_PROBE(write_done, static_cast<int>(record->context().level), fmt.data(), fmt.size(),
+                      record->context().location.file_name(), record->context().location.line());
+    }
+
+    static constexpr bool is_single_threaded = std::is_same_v<ThreadingPolicy, SingleThreaded>;
+
+    using SinkList = std::shared_ptr<const std::vector<std::shared_ptr<LogSink>>>;
+
+    // 持有mutex_时调用，把当前的sink列表复制一份发布给pressure
+    void publish_sinks() {
+        sinks_snapshot_.store(std::make_shared<const std::vector<std::shared_ptr<LogSink>>>(sinks_),
+                              std::memory_order_release);
+    }
+
+    mutable mutex_type mutex_;
     std::vector<std::shared_ptr<LogSink>> sinks_;
-    Level min_level_;// 全局最小日志等级
+    typename ThreadingPolicy::template atomic_type<SinkList> sinks_snapshot_{
+        std::make_shared<const std::vector<std::shared_ptr<LogSink>>>()};
+    typename ThreadingPolicy::template atomic_type<Level> min_level_;// 全局最小日志等级
     std::shared_ptr<asio::io_context> io_context_;
+    [[no_unique_address]] std::conditional_t<is_single_threaded, detail::ForkGate, detail::NoForkGate> fork_gate_;
 };
 
+// 放在类外定义并禁止内联，避免在每个调用点展开std::vformat
+template<typename ThreadingPolicy>
+CPP_LOG_NOINLINE void BasicLogger<ThreadingPolicy>::vlog(Level level,
+                                                       const std::source_location& location,
+                                                       std::string_view fmt,
+                                                       std::format_args args) {
+    CPP_LOG_PROBE(log_entry, static_cast<int>(level), fmt.data(), fmt.size(), location.file_name(), location.line());
+    // 日志记录只构建一次，所有输出目标共享同一份
+    dispatch(LogRecord::create(level, location, fmt, args), fmt);
+}
+
+template<typename ThreadingPolicy>
+CPP_LOG_NOINLINE void BasicLogger<ThreadingPolicy>::vlog_kv(Level level,
+                                                          const std::source_location& location,
+                                                          std::string_view message,
+                                                          std::span<const Field> fields,
+                                                          std::chrono::nanoseconds elapsed) {
+    CPP_LOG_PROBE(log_entry, static_cast<int>(level), message.data(), message.size(),
+                  location.file_name(), location.line());
+    dispatch(LogRecord::create(level, location, message, fields, elapsed), message);
+}
+
+// 多线程日志记录器
+using Logger = BasicLogger<MultiThreaded>;
+// 单线程日志记录器，用于事件循环等只有一个线程写日志的场景
+using LoggerST = BasicLogger<SingleThreaded>;
+
 // 默认的全局日志记录器
 namespace detail {
     class DefaultLogger {
@@ -142,20 +317,19 @@ namespace detail {
 
     private:
         DefaultLogger() {
-            // 创建异步控制台输出
+            // 创建异步控制台输出，运行在进程级的LogBackend上
             auto console_sink = std::make_shared<AsyncConsoleSink>(logger_.get_io_context());
-            console_sink->set_formatter(std::make_shared<DefaultFormatter>());
+            console_sink->set_formatter(shared_default_formatter());
             logger_.add_sink(console_sink);
-            
-            // 启动io_context运行线程
-            auto& ioc = logger_.get_io_context();
-            io_thread_ = std::thread([&ioc]() {
-                ioc.run();
-            });io_thread_.detach();  // 让线程在后台运行
+        }
+
+        ~DefaultLogger() {
+            // 在后台线程仍然运行时析构sink，让异步sink写完退出前提交的日志；
+            // LogBackend由它自己的析构函数停止，其他仍然存活的logger不受影响
+            logger_.clear_sinks();
         }
 
         Logger logger_;
-        std::thread io_thread_;
     };
 
     inline Logger& default_logger() {
@@ -193,16 +367,117 @@ void fatal(const std::source_location& location,
     detail::default_logger().fatal(location, fmt, std::forward<Args>(args)...);
 }
 
+template<typename... Fields>
+void debug_kv(const std::source_location& location, std::string_view message, const Fields&... fields) {
+    detail::default_logger().debug_kv(location, message, fields...);
+}
+
+template<typename... Fields>
+void info_kv(const std::source_location& location, std::string_view message, const Fields&... fields) {
+    detail::default_logger().info_kv(location, message, fields...);
+}
+
+template<typename... Fields>
+void warn_kv(const std::source_location& location, std::string_view message, const Fields&... fields) {
+    detail::default_logger().warn_kv(location, message, fields...);
+}
+
+template<typename... Fields>
+void error_kv(const std::source_location& location, std::string_view message, const Fields&... fields) {
+    detail::default_logger().error_kv(location, message, fields...);
+}
+
+template<typename... Fields>
+void fatal_kv(const std::source_location& location, std::string_view message, const Fields&... fields) {
+    detail::default_logger().fatal_kv(location, message, fields...);
+}
+
 // 设置全局日志等级的便捷函数
 inline void set_level(Level level) {
     detail::default_logger().set_level(level);
 }
 
+// 默认日志记录器的负载
+inline double pressure() {
+    return detail::default_logger().pressure();
+}
+
+inline Level pressure_level() {
+    return detail::default_logger().pressure_level();
+}
+
+namespace detail {
+    // callsite探针的fmt参数：格式字符串字面量、constexpr的string_view或std::format_string
+    template<typename T>
+    std::string_view callsite_text(const T& fmt) {
+        if constexpr (requires { fmt.get(); }) {
+            return fmt.get();
+        } else {
+            return std::string_view(fmt);
+        }
+    }
+} // namespace detail
+
+// 调用点：带上调用位置调用对应的日志函数，宏始终是一个表达式。
+// 启用USDT时callsite探针放在宏展开出的lambda里，每个调用点各有一个探针（而不是每个模板实例一个），
+// 在等级过滤之前触发；未启用时只转发参数。
+// 格式字符串是常量表达式，探针再取一次它的值没有副作用
+#define CPP_LOG_FIRST_ARG(...) CPP_LOG_FIRST_ARG_IMPL(__VA_ARGS__, 0)
+#define CPP_LOG_FIRST_ARG_IMPL(first, ...) first
+#ifdef CPP_LOG_HAS_USDT
+#define CPP_LOG_CALLSITE(level, function, ...) \
+    ([](const std::source_location& cpp_log_location_, std::string_view cpp_log_fmt_) noexcept { \
+         CPP_LOG_PROBE(callsite, static_cast<int>(level), cpp_log_fmt_.data(), cpp_log_fmt_.size(), \
+                       cpp_log_location_.file_name(), cpp_log_location_.line()); \
+     }(std::source_location::current(), ::cpp_log::detail::callsite_text(CPP_LOG_FIRST_ARG(__VA_ARGS__))), \
+     function(std::source_location::current(), __VA_ARGS__))
+// 结构化日志的消息可能有副作用，作为lambda的参数只求值一次，探针和日志函数共用
+#define CPP_LOG_CALLSITE_KV(level, function, ...) \
+    ([](const std::source_location& cpp_log_location_, std::string_view cpp_log_message_, \
+        const auto&... cpp_log_fields_) { \
+         CPP_LOG_PROBE(callsite, static_cast<int>(level), cpp_log_message_.data(), cpp_log_message_.size(), \
+                       cpp_log_location_.file_name(), cpp_log_location_.line()); \
+         function(cpp_log_location_, cpp_log_message_, cpp_log_fields_...); \
+     }(std::source_location::current(), __VA_ARGS__))
+#else
+#define CPP_LOG_CALLSITE(level, function, ...) function(std::source_location::current(), __VA_ARGS__)
+#define CPP_LOG_CALLSITE_KV(level, function, ...) function(std::source_location::current(), __VA_ARGS__)
+#endif
+
 // 宏定义，简化使用（可选）
-#define CPP_LOG_DEBUG(...) ::cpp_log::debug(std::source_location::current(), __VA_ARGS__)
-#define CPP_LOG_INFO(...) ::cpp_log::info(std::source_location::current(), __VA_ARGS__)
-#define CPP_LOG_WARN(...) ::cpp_log::warn(std::source_location::current(), __VA_ARGS__)
-#define CPP_LOG_ERROR(...) ::cpp_log::error(std::source_location::current(), __VA_ARGS__)
-#define CPP_LOG_FATAL(...) ::cpp_log::fatal(std::source_location::current(), __VA_ARGS__)
+#define CPP_LOG_DEBUG(...) CPP_LOG_CALLSITE(::cpp_log::Level::Debug, ::cpp_log::debug, __VA_ARGS__)
+#define CPP_LOG_INFO(...) CPP_LOG_CALLSITE(::cpp_log::Level::Info, ::cpp_log::info, __VA_ARGS__)
+#define CPP_LOG_WARN(...) CPP_LOG_CALLSITE(::cpp_log::Level::Warning, ::cpp_log::warn, __VA_ARGS__)
+#define CPP_LOG_ERROR(...) CPP_LOG_CALLSITE(::cpp_log::Level::Error, ::cpp_log::error, __VA_ARGS__)
+#define CPP_LOG_FATAL(...) CPP_LOG_CALLSITE(::cpp_log::Level::Fatal, ::cpp_log::fatal, __VA_ARGS__)
+
+// 结构化日志宏：CPP_LOG_INFO_KV("order filled", kv("qty", q), kv("px", p))
+#define CPP_LOG_DEBUG_KV(...) CPP_LOG_CALLSITE_KV(::cpp_log::Level::Debug, ::cpp_log::debug_kv, __VA_ARGS__)
+#define CPP_LOG_INFO_KV(...) CPP_LOG_CALLSITE_KV(::cpp_log::Level::Info, ::cpp_log::info_kv, __VA_ARGS__)
+#define CPP_LOG_WARN_KV(...) CPP_LOG_CALLSITE_KV(::cpp_log::Level::Warning, ::cpp_log::warn_kv, __VA_ARGS__)
+#define CPP_LOG_ERROR_KV(...) CPP_LOG_CALLSITE_KV(::cpp_log::Level::Error, ::cpp_log::error_kv, __VA_ARGS__)
+#define CPP_LOG_FATAL_KV(...) CPP_LOG_CALLSITE_KV(::cpp_log::Level::Fatal, ::cpp_log::fatal_kv, __VA_ARGS__)
+
+#define CPP_LOG_CONCAT_IMPL(a, b) a##b
+#define CPP_LOG_CONCAT(a, b) CPP_LOG_CONCAT_IMPL(a, b)
+
+// 作用域计时宏，离开作用域时输出耗时，level未启用时没有任何开销
+// CPP_LOG_SCOPE_TIMER(cpp_log::Level::Debug, "load config");
+#define CPP_LOG_SCOPE_TIMER(level, name) \
+    ::cpp_log::ScopeTimer CPP_LOG_CONCAT(cpp_log_scope_timer_, __LINE__)( \
+        ::cpp_log::detail::default_logger(), level, name)
+
+// 只在耗时达到threshold（std::chrono的时长）时输出，用于发现慢路径
+#define CPP_LOG_SCOPE_TIMER_IF_SLOWER(level, name, threshold) \
+    ::cpp_log::ScopeTimer CPP_LOG_CONCAT(cpp_log_scope_timer_, __LINE__)( \
+        ::cpp_log::detail::default_logger(), level, name, \
+        std::chrono::duration_cast<std::chrono::nanoseconds>(threshold))
+
+// 每个调用点累计耗时，每隔period输出一条count/min/avg/max汇总
+#define CPP_LOG_SCOPE_TIMER_AGGREGATE(level, name, period) \
+    static ::cpp_log::TimerStats CPP_LOG_CONCAT(cpp_log_timer_stats_, __LINE__){ \
+        std::chrono::duration_cast<std::chrono::nanoseconds>(period)}; \
+    ::cpp_log::ScopeTimer CPP_LOG_CONCAT(cpp_log_scope_timer_, __LINE__)( \
+        ::cpp_log::detail::default_logger(), level, name, CPP_LOG_CONCAT(cpp_log_timer_stats_, __LINE__))
 
 } // namespace cpp_log
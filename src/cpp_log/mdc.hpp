@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstdint>
+#include <format>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include "cpp_log/fields.hpp"
+
+namespace cpp_log {
+
+// 诊断上下文中的一个值，保持原本的类型，只在格式化器输出时才转换成文本
+// 类型的规则与kv()相同，字符串复制一份保存
+struct MdcValue {
+    FieldType type = FieldType::String;
+    std::uint64_t bits = 0;  // 数值类型的二进制表示
+    std::string text;        // 字符串类型的值
+
+    // 以结构化字段的形式读取，字符串引用text
+    Field field(std::string_view key = {}) const {
+        return {key, type, bits, text};
+    }
+};
+
+// 诊断上下文（MDC）的一层，创建后不再修改
+// 每层指向外层，整个上下文是一条不可变链表，日志记录只需要复制头指针
+struct MdcFrame {
+    std::string key;
+    MdcValue value;
+    std::shared_ptr<const MdcFrame> parent;
+};
+
+// 某一时刻的诊断上下文，为空表示没有任何键值
+using MdcSnapshot = std::shared_ptr<const MdcFrame>;
+
+class LogScope;
+
+namespace detail {
+    // 线程当前的诊断上下文：scope非空时为该作用域（它的frame可能还没有生成），否则为snapshot
+    struct MdcState {
+        LogScope* scope = nullptr;
+        MdcSnapshot snapshot;
+    };
+
+    inline MdcState& mdc_state() {
+        thread_local MdcState state;
+        return state;
+    }
+
+    // kv()支持的类型保持原本的类型，其他可格式化的类型在压入时格式化成字符串
+    template<typename T>
+    MdcValue make_mdc_value(const T& value) {
+        if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T> ||
+                      std::is_convertible_v<const T&, std::string_view>) {
+            Field field = kv({}, value);
+            return {field.type, field.bits, std::string(field.text)};
+        } else {
+            return {FieldType::String, 0, std::format("{}", value)};
+        }
+    }
+
+    inline MdcSnapshot current_mdc();
+} // namespace detail
+
+// 获取当前线程的诊断上下文
+inline MdcSnapshot mdc_snapshot() {
+    return detail::current_mdc();
+}
+
+// 在上下文中查找key，内层覆盖外层，找不到时返回nullptr
+inline const MdcValue* mdc_find(const MdcSnapshot& snapshot, std::string_view key) {
+    for (const MdcFrame* frame = snapshot.get(); frame; frame = frame->parent.get()) {
+        if (frame->key == key) {
+            return &frame->value;
+        }
+    }
+    return nullptr;
+}
+
+// 把值以文本形式追加到out，字符串原样追加
+inline void append_mdc_value(std::string& out, const MdcValue& value) {
+    append_field_value(out, value.field());
+}
+
+// 以"key=value key=value"的形式输出上下文，外层在前，同名key只输出最内层的值
+inline std::string mdc_to_string(const MdcSnapshot& snapshot) {
+    std::string result;
+    if (!snapshot) {
+        return result;
+    }
+    // 链表从内层指向外层，先递归到最外层再依次输出
+    auto append = [&](auto& self, const MdcFrame* frame) -> void {
+        if (!frame) {
+            return;
+        }
+        self(self, frame->parent.get());
+        if (mdc_find(snapshot, frame->key) != &frame->value) {
+            return;  // 被内层同名key覆盖
+        }
+        if (!result.empty()) {
+            result += ' ';
+        }
+        result += frame->key;
+        result += '=';
+        append_mdc_value(result, frame->value);
+    };
+    append(append, snapshot.get());
+    return result;
+}
+
+// 在当前线程的诊断上下文中压入一个键值，离开作用域时恢复
+// LogScope scope{"req", request_id};
+// 之后这个线程上的每条日志都带着req，由格式化器的%X或%X{req}输出。
+// 压入时只保存键和值，不格式化也不分配上下文节点；作用域内第一次创建日志记录时
+// 才生成不可变的frame供记录共享。同一线程上的LogScope必须按构造的相反顺序析构
+class LogScope {
+public:
+    template<typename T>
+    LogScope(std::string key, const T& value)
+        : key_(std::move(key))
+        , value_(detail::make_mdc_value(value))
+        , previous_(std::exchange(detail::mdc_state(), detail::MdcState{this, nullptr})) {}
+
+    // 在另一个线程上恢复之前获取的上下文，例如把任务交给线程池时
+    explicit LogScope(MdcSnapshot snapshot)
+        : previous_(std::exchange(detail::mdc_state(), detail::MdcState{nullptr, std::move(snapshot)})) {}
+
+    ~LogScope() {
+        detail::mdc_state() = std::move(previous_);
+    }
+
+    LogScope(const LogScope&) = delete;
+    LogScope& operator=(const LogScope&) = delete;
+
+private:
+    friend MdcSnapshot detail::current_mdc();
+
+    // 本层的frame，第一次需要时生成，外层尚未生成的frame一并生成
+    const MdcSnapshot& frame() {
+        if (!frame_) {
+            auto parent = previous_.scope ? previous_.scope->frame() : previous_.snapshot;
+            frame_ = std::make_shared<const MdcFrame>(MdcFrame{std::move(key_), std::move(value_), std::move(parent)});
+        }
+        return frame_;
+    }
+
+    std::string key_;
+    MdcValue value_;
+    detail::MdcState previous_;
+    MdcSnapshot frame_;
+};
+
+namespace detail {
+    inline MdcSnapshot current_mdc() {
+        auto& state = mdc_state();
+        return state.scope ? state.scope->frame() : state.snapshot;
+    }
+} // namespace detail
+
+} // namespace cpp_log
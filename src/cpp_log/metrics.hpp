@@ -0,0 +1,177 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cpp_log {
+
+// 单调递增的计数器，无锁
+class Counter {
+public:
+    void add(std::uint64_t value = 1) {
+        value_.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    std::uint64_t value() const {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<std::uint64_t> value_{0};
+};
+
+// 可任意设置的瞬时值，无锁
+class Gauge {
+public:
+    void set(double value) {
+        value_.store(value, std::memory_order_relaxed);
+    }
+
+    double value() const {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<double> value_{0.0};
+};
+
+class Metrics;
+
+// 瞬时值的登记，析构时注销
+// 同名的登记共享同一个瞬时值，最后一个登记析构时从注册表中移除，
+// 适合随对象创建和销毁的指标，例如每个sink一组
+class GaugeRegistration {
+public:
+    GaugeRegistration(std::string name, std::shared_ptr<Gauge> gauge)
+        : name_(std::move(name))
+        , gauge_(std::move(gauge)) {}
+
+    GaugeRegistration(const GaugeRegistration&) = delete;
+    GaugeRegistration& operator=(const GaugeRegistration&) = delete;
+
+    ~GaugeRegistration();
+
+    Gauge& operator*() const {
+        return *gauge_;
+    }
+
+    Gauge* operator->() const {
+        return gauge_.get();
+    }
+
+    const std::string& name() const {
+        return name_;
+    }
+
+private:
+    std::string name_;
+    std::shared_ptr<Gauge> gauge_;
+};
+
+// 进程级的指标注册表
+// 按名字获取计数器和瞬时值，返回的引用在remove之前一直有效，
+// 调用方应在初始化时获取并保存，而不是每次记录时都查找；
+// 生命周期不受调用方控制的对象使用shared_counter或register_gauge共享所有权
+class Metrics {
+public:
+    static Metrics& instance() {
+        // 故意不析构：静态logger上的sink在退出时才析构，之后仍会注销它们的指标
+        static Metrics* metrics = new Metrics;
+        return *metrics;
+    }
+
+    Counter& counter(const std::string& name) {
+        return *shared_counter(name);
+    }
+
+    // 与counter相同，但返回共享所有权：remove之后持有者仍然可以计数，只是不再出现在注册表中
+    std::shared_ptr<Counter> shared_counter(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& slot = counters_[name];
+        if (!slot) {
+            slot = std::make_shared<Counter>();
+        }
+        return slot;
+    }
+
+    Gauge& gauge(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return *gauge_slot(name).gauge;
+    }
+
+    // 登记一个瞬时值，返回的登记对象析构时自动注销
+    GaugeRegistration register_gauge(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& slot = gauge_slot(name);
+        ++slot.registrations;
+        return GaugeRegistration(name, slot.gauge);
+    }
+
+    // 移除同名的计数器和瞬时值，之前通过counter()或gauge()获取的引用随之失效；
+    // 通过shared_counter获取的计数器和通过register_gauge登记的瞬时值在持有者释放之前仍然可用
+    void remove(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        counters_.erase(name);
+        gauges_.erase(name);
+    }
+
+    // 获取所有指标的当前值，计数器在前，瞬时值在后，各自按名字排序
+    std::vector<std::pair<std::string, double>> snapshot() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<std::pair<std::string, double>> result;
+        for (const auto& [name, counter] : counters_) {
+            result.emplace_back(name, static_cast<double>(counter->value()));
+        }
+        for (const auto& [name, slot] : gauges_) {
+            result.emplace_back(name, slot.gauge->value());
+        }
+        return result;
+    }
+
+private:
+    friend class GaugeRegistration;
+
+    struct GaugeSlot {
+        std::shared_ptr<Gauge> gauge;
+        size_t registrations = 0;  // 尚未析构的登记数
+    };
+
+    Metrics() = default;
+
+    // 调用方持有mutex_
+    GaugeSlot& gauge_slot(const std::string& name) {
+        auto& slot = gauges_[name];
+        if (!slot.gauge) {
+            slot.gauge = std::make_shared<Gauge>();
+        }
+        return slot;
+    }
+
+    // 登记析构时调用；瞬时值已被remove或替换时不影响注册表中的新对象
+    void unregister_gauge(const std::string& name, const std::shared_ptr<Gauge>& gauge) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = gauges_.find(name);
+        if (it == gauges_.end() || it->second.gauge != gauge) {
+            return;
+        }
+        if (it->second.registrations > 0 && --it->second.registrations == 0) {
+            gauges_.erase(it);
+        }
+    }
+
+    mutable std::mutex mutex_;
+    std::map<std::string, std::shared_ptr<Counter>> counters_;
+    std::map<std::string, GaugeSlot> gauges_;
+};
+
+inline GaugeRegistration::~GaugeRegistration() {
+    Metrics::instance().unregister_gauge(name_, gauge_);
+}
+
+} // namespace cpp_log
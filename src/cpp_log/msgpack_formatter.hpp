@@ -0,0 +1,212 @@
+#pragma once
+
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include "cpp_log/level.hpp"
+#include "cpp_log/formatter.hpp"
+#include "cpp_log/fields.hpp"
+#include "cpp_log/mdc.hpp"
+
+namespace cpp_log {
+
+namespace detail {
+
+// 直接向缓冲区追加MessagePack编码
+class MsgpackWriter {
+public:
+    explicit MsgpackWriter(std::string& out) : out_(out) {}
+
+    void map(std::uint32_t size) {
+        if (size < 16) {
+            byte(0x80 | size);
+        } else if (size <= UINT16_MAX) {
+            byte(0xde);
+            big_endian(static_cast<std::uint16_t>(size));
+        } else {
+            byte(0xdf);
+            big_endian(size);
+        }
+    }
+
+    void str(std::string_view text) {
+        auto size = text.size();
+        if (size < 32) {
+            byte(0xa0 | static_cast<std::uint8_t>(size));
+        } else if (size <= UINT8_MAX) {
+            byte(0xd9);
+            byte(static_cast<std::uint8_t>(size));
+        } else if (size <= UINT16_MAX) {
+            byte(0xda);
+            big_endian(static_cast<std::uint16_t>(size));
+        } else {
+            byte(0xdb);
+            big_endian(static_cast<std::uint32_t>(size));
+        }
+        out_.append(text.data(), size);
+    }
+
+    void uint(std::uint64_t value) {
+        if (value < 128) {
+            byte(static_cast<std::uint8_t>(value));
+        } else if (value <= UINT8_MAX) {
+            byte(0xcc);
+            byte(static_cast<std::uint8_t>(value));
+        } else if (value <= UINT16_MAX) {
+            byte(0xcd);
+            big_endian(static_cast<std::uint16_t>(value));
+        } else if (value <= UINT32_MAX) {
+            byte(0xce);
+            big_endian(static_cast<std::uint32_t>(value));
+        } else {
+            byte(0xcf);
+            big_endian(value);
+        }
+    }
+
+    void sint(std::int64_t value) {
+        if (value >= 0) {
+            uint(static_cast<std::uint64_t>(value));
+        } else if (value >= -32) {
+            byte(static_cast<std::uint8_t>(value));  // negative fixint
+        } else if (value >= INT8_MIN) {
+            byte(0xd0);
+            byte(static_cast<std::uint8_t>(value));
+        } else if (value >= INT16_MIN) {
+            byte(0xd1);
+            big_endian(static_cast<std::uint16_t>(value));
+        } else if (value >= INT32_MIN) {
+            byte(0xd2);
+            big_endian(static_cast<std::uint32_t>(value));
+        } else {
+            byte(0xd3);
+            big_endian(static_cast<std::uint64_t>(value));
+        }
+    }
+
+    void float64(double value) {
+        byte(0xcb);
+        big_endian(std::bit_cast<std::uint64_t>(value));
+    }
+
+    void boolean(bool value) {
+        byte(value ? 0xc3 : 0xc2);
+    }
+
+    void field(const Field& field) {
+        switch (field.type) {
+            case FieldType::Bool: boolean(field.as_bool()); break;
+            case FieldType::Int: sint(field.as_int()); break;
+            case FieldType::UInt: uint(field.as_uint()); break;
+            case FieldType::Double: float64(field.as_double()); break;
+            case FieldType::String: str(field.as_string()); break;
+        }
+    }
+
+private:
+    void byte(std::uint8_t value) {
+        out_ += static_cast<char>(value);
+    }
+
+    template<typename T>
+    void big_endian(T value) {
+        for (int shift = (sizeof(T) - 1) * 8; shift >= 0; shift -= 8) {
+            byte(static_cast<std::uint8_t>(value >> shift));
+        }
+    }
+
+    std::string& out_;
+};
+
+} // namespace detail
+
+// MessagePack格式化器
+// 每条日志编码成一个帧：[4字节小端长度][MessagePack map]，map的内容为
+// ts（自1970年起的纳秒数）、level、file、line、thread、seq、msg，
+// 以及非空时的mdc（字符串map）和fields（保持字段原本类型的map）。
+// 输出是二进制的，文件sink不会对它去除颜色代码，可以配合FileSink、RotatingFileSink、
+// AsyncFileSink使用；tools/cpp_log_msgpack2json可以把文件转换成JSON Lines
+class MsgpackFormatter : public LogFormatter {
+public:
+    std::string format(const LogContext& context) override {
+        std::string out;
+        format_to(context, out);
+        return out;
+    }
+
+    void format_to(const LogContext& context, std::string& out) override {
+        size_t frame_start = out.size();
+        out.append(4, '\0');  // 长度在编码完成后回填
+
+        // 统计内层未被覆盖的mdc键值
+        std::uint32_t mdc_size = 0;
+        for (const MdcFrame* frame = context.mdc.get(); frame; frame = frame->parent.get()) {
+            if (mdc_find(context.mdc, frame->key) == &frame->value) {
+                ++mdc_size;
+            }
+        }
+        std::uint32_t field_count = 0;
+        for (auto it = context.fields.begin(); it != context.fields.end(); ++it) {
+            ++field_count;
+        }
+
+        detail::MsgpackWriter writer(out);
+        writer.map(7 + (mdc_size > 0) + (field_count > 0));
+        writer.str("ts");
+        writer.sint(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            context.timestamp.time_since_epoch()).count());
+        writer.str("level");
+        writer.str(get_level_string(context.level));
+        writer.str("file");
+        writer.str(context.location.file_name());
+        writer.str("line");
+        writer.uint(context.location.line());
+        writer.str("thread");
+        writer.str(detail::thread_id_text(context.thread_id));
+        writer.str("seq");
+        writer.uint(context.sequence);
+        writer.str("msg");
+        writer.str(context.message);
+
+        if (mdc_size > 0) {
+            writer.str("mdc");
+            writer.map(mdc_size);
+            std::string text;  // 数值类型的值在这里才转换成文本
+            for (const MdcFrame* frame = context.mdc.get(); frame; frame = frame->parent.get()) {
+                if (mdc_find(context.mdc, frame->key) == &frame->value) {
+                    writer.str(frame->key);
+                    if (frame->value.type == FieldType::String) {
+                        writer.str(frame->value.text);
+                    } else {
+                        text.clear();
+                        append_mdc_value(text, frame->value);
+                        writer.str(text);
+                    }
+                }
+            }
+        }
+
+        if (field_count > 0) {
+            writer.str("fields");
+            writer.map(field_count);
+            for (const auto& field : context.fields) {
+                writer.str(field.key);
+                writer.field(field);
+            }
+        }
+
+        auto length = static_cast<std::uint32_t>(out.size() - frame_start - 4);
+        for (int i = 0; i < 4; ++i) {
+            out[frame_start + i] = static_cast<char>(length >> (8 * i));
+        }
+    }
+
+    bool binary() const override {
+        return true;
+    }
+};
+
+} // namespace cpp_log
@@ -0,0 +1,339 @@
+#pragma once
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "cpp_log/backend.hpp"
+#include "cpp_log/formatter.hpp"
+#include "cpp_log/record.hpp"
+#include "cpp_log/sink.hpp"
+
+namespace cpp_log {
+
+namespace asio = boost::asio;
+
+// 并行格式化配置
+struct ParallelFormatOptions {
+    size_t formatter_threads = 2;  // 格式化线程数量
+    size_t batch_size = 256;       // 每批的最大条数，批次是格式化和写出的单位
+    std::chrono::milliseconds flush_interval{5};  // 未满的批次最多等待这么久就提交
+};
+
+// 并行格式化的异步输出
+// 生产者只把日志记录追加到当前批次；批次满了或者超过flush_interval后提交给格式化线程池，
+// 多个线程同时把不同批次格式化到各自的缓冲区。唯一的写线程按提交顺序取出已经格式化好的批次，
+// 通过write_formatted_batch交给每个sink并刷新，后提交的批次先格式化完也会等前面的批次写出。
+// 异步sink（asynchronous()为true）每批只入队不刷新，写线程不会等它的后台写出；
+// flush()等批次全部交出之后再刷新它们。
+// 使用同一个格式化器的sink共享一份格式化结果；没有格式化器的sink收到的是write_batch。
+// 构造时记录各sink的格式化器，之后对sink调用set_formatter不会生效。
+// 格式化器会被多个线程同时调用，内置的格式化器都没有可变状态，自定义格式化器也需要满足这一点
+class ParallelFormatSink : public LogSink {
+public:
+    explicit ParallelFormatSink(std::vector<std::shared_ptr<LogSink>> sinks,
+                                ParallelFormatOptions options = {})
+        : sinks_(std::move(sinks))
+        , options_(options)
+        , format_executor_(options.formatter_threads) {
+        if (sinks_.empty()) {
+            throw std::invalid_argument("ParallelFormatSink requires at least one sink");
+        }
+        options_.batch_size = std::max<size_t>(options_.batch_size, 1);
+
+        for (const auto& sink : sinks_) {
+            auto formatter = sink->formatter();
+            if (!formatter) {
+                sink_formatter_.push_back(no_formatter);
+                continue;
+            }
+            auto it = std::find(formatters_.begin(), formatters_.end(), formatter);
+            sink_formatter_.push_back(static_cast<size_t>(it - formatters_.begin()));
+            if (it == formatters_.end()) {
+                formatters_.push_back(std::move(formatter));
+            }
+        }
+
+        asio::co_spawn(format_executor_.get_io_context(), seal_loop(), asio::detached);
+    }
+
+    ~ParallelFormatSink() override {
+        flush();
+        running_ = false;
+    }
+
+    void write(const LogContext& context) override {
+        if (!should_log(context.level)) {
+            return;
+        }
+        write_record(LogRecord::create(context));
+    }
+
+    void write_record(const RecordPtr& record) override {
+        if (!should_log(record->context().level)) {
+            return;
+        }
+        submit(std::span<const RecordPtr>(&record, 1));
+    }
+
+    void write_batch(std::span<const RecordPtr> records) override {
+        submit(records);
+    }
+
+    // 提交当前未满的批次，并等待之前提交的日志全部写出，之后刷新异步sink
+    // 写线程长时间没有任何进展时放弃等待
+    void flush() override {
+        std::shared_ptr<Batch> sealed;
+        std::uint64_t target;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            sealed = seal_locked();
+            target = next_ticket_;
+        }
+        if (sealed) {
+            start_format(std::move(sealed));
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto last_written = written_batches_;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (written_batches_ < target) {
+            written_cv_.wait_for(lock, std::chrono::milliseconds(10));
+            if (written_batches_ != last_written) {
+                last_written = written_batches_;
+                deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            } else if (std::chrono::steady_clock::now() >= deadline) {
+                break;
+            }
+        }
+        lock.unlock();
+
+        for (const auto& sink : sinks_) {
+            if (sink->asynchronous()) {
+                sink->flush();
+            }
+        }
+    }
+
+    bool healthy() const override {
+        return std::all_of(sinks_.begin(), sinks_.end(), [](const auto& sink) { return sink->healthy(); });
+    }
+
+    // 各sink中最高的负载，批次队列本身没有容量限制
+    double pressure() const override {
+        double result = 0.0;
+        for (const auto& sink : sinks_) {
+            result = std::max(result, sink->pressure());
+        }
+        return result;
+    }
+
+    // 批次由后台的格式化线程和写出线程处理
+    bool asynchronous() const override {
+        return true;
+    }
+
+    // 已提交但尚未写出的日志条数
+    size_t pending() const {
+        return pending_.load(std::memory_order_relaxed);
+    }
+
+    size_t formatter_threads() const {
+        return std::max<size_t>(options_.formatter_threads, 1);
+    }
+
+private:
+    static constexpr size_t no_formatter = static_cast<size_t>(-1);
+
+    // 一批日志，格式化线程填充texts和formatted后置ready，写线程只读取ready的批次
+    struct Batch {
+        std::uint64_t ticket = 0;
+        std::vector<RecordPtr> records;
+        std::vector<std::string> texts;                       // 每个格式化器一块缓冲区
+        std::vector<std::vector<FormattedRecord>> formatted;  // 每个格式化器对应的逐条文本
+        std::atomic<bool> ready{false};
+    };
+
+    void submit(std::span<const RecordPtr> records) {
+        std::vector<std::shared_ptr<Batch>> sealed;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& record : records) {
+                if (!should_log(record->context().level)) {
+                    continue;
+                }
+                if (!open_) {
+                    open_ = std::make_shared<Batch>();
+                    open_->records.reserve(options_.batch_size);
+                }
+                open_->records.push_back(record);
+                pending_.fetch_add(1, std::memory_order_relaxed);
+                if (open_->records.size() >= options_.batch_size) {
+                    sealed.push_back(seal_locked());
+                }
+            }
+        }
+        for (auto& batch : sealed) {
+            start_format(std::move(batch));
+        }
+    }
+
+    // 给当前批次分配顺序号并加入待写队列，调用方持有mutex_
+    std::shared_ptr<Batch> seal_locked() {
+        if (!open_ || open_->records.empty()) {
+            return nullptr;
+        }
+        open_->ticket = next_ticket_++;
+        in_flight_.push_back(open_);
+        return std::exchange(open_, nullptr);
+    }
+
+    void start_format(std::shared_ptr<Batch> batch) {
+        asio::post(format_executor_.get_io_context(), [this, batch = std::move(batch)]() {
+            format(*batch);
+            batch->ready.store(true, std::memory_order_release);
+            asio::post(writer_executor_.get_io_context(), [this]() { drain(); });
+        });
+    }
+
+    // 在格式化线程中执行，只格式化至少有一个sink接受的记录
+    void format(Batch& batch) {
+        batch.texts.resize(formatters_.size());
+        batch.formatted.resize(formatters_.size());
+        std::vector<size_t> ends;
+        ends.reserve(batch.records.size());
+
+        for (size_t f = 0; f < formatters_.size(); ++f) {
+            auto min_level = Level::Fatal;
+            for (size_t i = 0; i < sinks_.size(); ++i) {
+                if (sink_formatter_[i] == f) {
+                    min_level = std::min(min_level, sinks_[i]->level());
+                }
+            }
+
+            auto& text = batch.texts[f];
+            ends.clear();
+            for (const auto& record : batch.records) {
+                if (record->context().level >= min_level) {
+                    formatters_[f]->format_to(record->context(), text);
+                }
+                ends.push_back(text.size());
+            }
+
+            // 缓冲区不再增长之后才能取出指向它的视图
+            auto& formatted = batch.formatted[f];
+            formatted.reserve(batch.records.size());
+            size_t start = 0;
+            for (size_t r = 0; r < batch.records.size(); ++r) {
+                formatted.push_back({batch.records[r], std::string_view(text).substr(start, ends[r] - start)});
+                start = ends[r];
+            }
+        }
+    }
+
+    // 在写线程中执行，按顺序号写出所有已经格式化好的批次
+    void drain() {
+        while (true) {
+            std::shared_ptr<Batch> batch;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                reset_after_fork();
+                if (in_flight_.empty() || !in_flight_.front()->ready.load(std::memory_order_acquire)) {
+                    return;
+                }
+                batch = std::move(in_flight_.front());
+                in_flight_.pop_front();
+            }
+
+            for (size_t i = 0; i < sinks_.size(); ++i) {
+                if (sink_formatter_[i] == no_formatter) {
+                    sinks_[i]->write_batch(batch->records);
+                } else {
+                    sinks_[i]->write_formatted_batch(batch->formatted[sink_formatter_[i]]);
+                }
+                // 异步sink的flush要等它的后台写完，每批都等会让所有sink跟着最慢的一个
+                if (!sinks_[i]->asynchronous()) {
+                    sinks_[i]->flush();
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ++written_batches_;
+                pending_.fetch_sub(batch->records.size(), std::memory_order_relaxed);
+            }
+            written_cv_.notify_all();
+        }
+    }
+
+    // 在fork出的子进程中丢弃从父进程继承的批次，这些日志由父进程写出，调用方持有mutex_
+    void reset_after_fork() {
+        auto generation = detail::fork_generation().load(std::memory_order_relaxed);
+        if (generation == generation_) {
+            return;
+        }
+        generation_ = generation;
+        size_t dropped = open_ ? open_->records.size() : 0;
+        for (const auto& batch : in_flight_) {
+            dropped += batch->records.size();
+        }
+        written_batches_ += in_flight_.size();
+        in_flight_.clear();
+        open_.reset();
+        pending_.fetch_sub(dropped, std::memory_order_relaxed);
+    }
+
+    // 定期提交未满的批次，低负载时日志最多延迟flush_interval
+    asio::awaitable<void> seal_loop() {
+        asio::steady_timer timer(co_await asio::this_coro::executor);
+        while (running_) {
+            timer.expires_after(options_.flush_interval);
+            co_await timer.async_wait(asio::use_awaitable);
+            std::shared_ptr<Batch> sealed;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                sealed = seal_locked();
+            }
+            if (sealed) {
+                start_format(std::move(sealed));
+            }
+        }
+    }
+
+    std::vector<std::shared_ptr<LogSink>> sinks_;
+    std::vector<std::shared_ptr<LogFormatter>> formatters_;  // 去重后的格式化器
+    std::vector<size_t> sink_formatter_;  // 每个sink使用的格式化器在formatters_中的位置
+    ParallelFormatOptions options_;
+
+    std::mutex mutex_;
+    std::condition_variable written_cv_;
+    std::shared_ptr<Batch> open_;                   // 正在追加的批次
+    std::deque<std::shared_ptr<Batch>> in_flight_;  // 已提交未写出的批次，按顺序号排列
+    std::uint64_t next_ticket_ = 0;
+    std::uint64_t written_batches_ = 0;
+    std::uint64_t generation_ = detail::fork_generation().load(std::memory_order_relaxed);
+    std::atomic<size_t> pending_{0};
+    std::atomic<bool> running_{true};
+
+    // 最后声明，析构时先停止格式化线程（它们会向写线程投递任务），再停止写线程，
+    // 之后不会再有任务访问上面的成员
+    SinkExecutor writer_executor_;
+    SinkExecutor format_executor_;
+};
+
+} // namespace cpp_log
@@ -0,0 +1,26 @@
+#pragma once
+
+// SystemTap USDT静态探针
+// 定义CPP_LOG_ENABLE_USDT（CMake选项CPP_LOG_ENABLE_USDT）并且能找到<sys/sdt.h>时，
+// 各探针点编译为一条nop指令并在ELF的.note.stapsdt中登记，可以用bpftrace、perf、
+// SystemTap直接挂载，不需要启用任何sink；否则探针宏展开为空语句，参数不会被求值。
+//
+// 探针（provider为cpp_log）：
+//   callsite(level, fmt, size, file, line)     CPP_LOG_*宏的调用点，在等级过滤之前；每个调用点各登记一个探针
+//   log_entry(level, fmt, size, file, line)    Logger通过等级过滤、开始构建日志记录（BasicLogger的vlog/vlog_kv）
+//   write_done(level, fmt, size, file, line)   所有sink的write_record返回，异步sink此时只是入队
+//   async_written(sink, count)                 异步sink在后台线程写出并刷新了count条日志
+// level为Level的整数值；fmt为格式字符串（结构化日志为消息文本），不一定以'\0'结尾，
+// 长度由size给出，bpftrace中用str(arg1, arg2)读取；file为以'\0'结尾的源文件名。
+#if defined(CPP_LOG_ENABLE_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define CPP_LOG_HAS_USDT 1
+#endif
+#endif
+
+#ifdef CPP_LOG_HAS_USDT
+#define CPP_LOG_PROBE(name, ...) STAP_PROBEV(cpp_log, name, __VA_ARGS__)
+#else
+#define CPP_LOG_PROBE(name, ...) do { } while (0)
+#endif
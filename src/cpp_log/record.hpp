@@ -0,0 +1,307 @@
+#pragma once
+
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <iterator>
+#include <source_location>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include "cpp_log/level.hpp"
+#include "cpp_log/color.hpp"
+#include "cpp_log/formatter.hpp"
+#include "cpp_log/mdc.hpp"
+#include "cpp_log/sequence.hpp"
+#include "cpp_log/fields.hpp"
+
+namespace cpp_log {
+
+class LogRecord;
+
+// 指向共享日志记录的指针，复制只增加引用计数
+using RecordPtr = boost::intrusive_ptr<const LogRecord>;
+
+namespace detail {
+
+// 只写一次的文本缓存
+// 第一个请求者生成文本并保存，之后使用同一个key的请求直接返回缓存；
+// 其他key或者缓存正在生成时，文本生成到调用方提供的scratch中，不等待。
+// fill(out)把文本追加到已清空的out中，缓存和scratch都保留已分配的容量。
+// 生成时抛出异常则缓存恢复为空，之后的请求者可以重新生成
+class TextCache {
+public:
+    template<typename Fill>
+    std::string_view get(const void* key, Fill&& fill, std::string& scratch) {
+        int state = state_.load(std::memory_order_acquire);
+        if (state == Ready) {
+            if (key_ == key) {
+                return text_;
+            }
+        } else if (state == Empty) {
+            int expected = Empty;
+            if (state_.compare_exchange_strong(expected, Busy, std::memory_order_acquire)) {
+                text_.clear();
+                try {
+                    fill(text_);
+                } catch (...) {
+                    text_.clear();
+                    state_.store(Empty, std::memory_order_release);
+                    throw;
+                }
+                key_ = key;
+                state_.store(Ready, std::memory_order_release);
+                return text_;
+            }
+        }
+        scratch.clear();
+        fill(scratch);
+        return scratch;
+    }
+
+    // 在第一个请求者之前放入已经生成好的文本，缓存已被占用时忽略
+    void put(const void* key, std::string_view text) {
+        int expected = Empty;
+        if (state_.compare_exchange_strong(expected, Busy, std::memory_order_acquire)) {
+            try {
+                text_.assign(text);
+            } catch (...) {
+                state_.store(Empty, std::memory_order_release);
+                throw;
+            }
+            key_ = key;
+            state_.store(Ready, std::memory_order_release);
+        }
+    }
+
+    // 记录回收时清空，保留已分配的容量
+    void reset() {
+        key_ = nullptr;
+        text_.clear();
+        state_.store(Empty, std::memory_order_relaxed);
+    }
+
+private:
+    enum { Empty, Busy, Ready };
+
+    std::atomic<int> state_{Empty};
+    const void* key_ = nullptr;
+    std::string text_;
+};
+
+// 已释放日志记录的缓存池
+// 固定数量的槽位，取出和放回都只用一次原子交换，不加锁，因此也不受fork影响
+class RecordPool {
+public:
+    static constexpr size_t capacity = 256;
+
+    static RecordPool& instance() {
+        // 故意不析构：静态对象析构之后仍可能有sink释放日志记录
+        static RecordPool* pool = new RecordPool;
+        return *pool;
+    }
+
+    // 取出一条空闲记录，池为空时返回nullptr
+    LogRecord* acquire() {
+        if (size_.load(std::memory_order_relaxed) == 0) {
+            return nullptr;
+        }
+        size_t start = hint();
+        for (size_t i = 0; i < capacity; ++i) {
+            auto& slot = slots_[(start + i) % capacity];
+            if (auto* record = slot.exchange(nullptr, std::memory_order_acquire)) {
+                size_.fetch_sub(1, std::memory_order_relaxed);
+                return record;
+            }
+        }
+        return nullptr;
+    }
+
+    // 放回一条记录，池已满时返回false，由调用方释放
+    bool release(LogRecord* record) {
+        if (size_.load(std::memory_order_relaxed) >= capacity) {
+            return false;
+        }
+        size_t start = hint();
+        for (size_t i = 0; i < capacity; ++i) {
+            auto& slot = slots_[(start + i) % capacity];
+            LogRecord* expected = nullptr;
+            if (slot.compare_exchange_strong(expected, record, std::memory_order_release)) {
+                size_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    RecordPool() = default;
+
+    // 不同线程从不同的槽位开始查找，减少争用
+    static size_t hint() {
+        static std::atomic<size_t> next{0};
+        thread_local size_t start = next.fetch_add(capacity / 8, std::memory_order_relaxed);
+        return start;
+    }
+
+    std::array<std::atomic<LogRecord*>, capacity> slots_{};
+    std::atomic<size_t> size_{0};
+};
+
+} // namespace detail
+
+// 不可变的日志记录
+// 每条日志只创建一次，以引用计数指针交给所有sink和后台线程，不再复制消息。
+// 记录按格式化器缓存格式化后的文本和去除颜色代码的纯文本，
+// 共用同一个格式化器的sink只格式化一次。最后一个持有者释放后回到RecordPool复用
+class LogRecord {
+public:
+    LogRecord(const LogRecord&) = delete;
+    LogRecord& operator=(const LogRecord&) = delete;
+
+    // 在调用线程上格式化消息，直接写入记录内复用的缓冲区
+    // 每个create在取得记录后立即交给RecordPtr，格式化或复制字段时抛出异常，记录也会回到缓存池
+    static RecordPtr create(Level level,
+                            const std::source_location& location,
+                            std::string_view fmt,
+                            std::format_args args) {
+        LogRecord* record = allocate();
+        RecordPtr result(record);
+        auto& context = record->context_;
+        context.level = level;
+        context.timestamp = std::chrono::system_clock::now();
+        context.location = location;
+        context.thread_id = std::this_thread::get_id();
+        std::vformat_to(std::back_inserter(context.message), fmt, args);
+        context.elapsed = std::chrono::nanoseconds::zero();
+        context.sequence = detail::next_sequence();
+        context.mdc = detail::current_mdc();
+        return result;
+    }
+
+    // 消息不经过格式化，结构化字段编码进记录，elapsed非0时是一条计时日志
+    static RecordPtr create(Level level,
+                            const std::source_location& location,
+                            std::string_view message,
+                            std::span<const Field> fields,
+                            std::chrono::nanoseconds elapsed = std::chrono::nanoseconds::zero()) {
+        LogRecord* record = allocate();
+        RecordPtr result(record);
+        auto& context = record->context_;
+        context.level = level;
+        context.timestamp = std::chrono::system_clock::now();
+        context.location = location;
+        context.thread_id = std::this_thread::get_id();
+        context.message.assign(message);
+        for (const auto& field : fields) {
+            context.fields.append(field);
+        }
+        context.elapsed = elapsed;
+        context.sequence = detail::next_sequence();
+        context.mdc = detail::current_mdc();
+        return result;
+    }
+
+    // 从已有的日志上下文复制一份
+    static RecordPtr create(const LogContext& context) {
+        LogRecord* record = allocate();
+        RecordPtr result(record);
+        record->context_.level = context.level;
+        record->context_.timestamp = context.timestamp;
+        record->context_.location = context.location;
+        record->context_.thread_id = context.thread_id;
+        record->context_.message.assign(context.message);
+        record->context_.sequence = context.sequence;
+        record->context_.mdc = context.mdc;
+        record->context_.fields.assign(context.fields);
+        record->context_.elapsed = context.elapsed;
+        return result;
+    }
+
+    const LogContext& context() const {
+        return context_;
+    }
+
+    // 用formatter格式化后的文本
+    // formatter与第一次请求时相同则返回缓存，否则格式化到scratch中
+    std::string_view text(LogFormatter& formatter, std::string& scratch) const {
+        return text_.get(&formatter, [&](std::string& out) { formatter.format_to(context_, out); }, scratch);
+    }
+
+    // 放入已经用formatter格式化好的文本，之后text(formatter)直接返回它，不再格式化
+    // 记录已经缓存了文本（不论来自哪个格式化器）时不做任何事
+    void cache_text(const LogFormatter& formatter, std::string_view text) const {
+        text_.put(&formatter, text);
+    }
+
+    // 去除颜色代码后的文本，用于文件等不支持颜色的输出
+    // 二进制格式或者文本中没有颜色代码时与text()相同，不再复制一份（文件sink对二进制格式不调用它）；
+    // 文本生成在scratch中时就地去除，否则去除后的文本另外缓存
+    std::string_view plain_text(LogFormatter& formatter, std::string& scratch) const {
+        auto formatted = text(formatter, scratch);
+        if (formatter.binary() || formatted.find('\033') == std::string_view::npos) {
+            return formatted;
+        }
+        if (formatted.data() == scratch.data()) {
+            color::erase_color_codes(scratch);
+            return scratch;
+        }
+        return plain_.get(&formatter, [&](std::string& out) {
+            color::append_without_color_codes(formatted, out);
+        }, scratch);
+    }
+
+private:
+    LogRecord() = default;
+
+    static LogRecord* allocate() {
+        if (auto* record = detail::RecordPool::instance().acquire()) {
+            return record;
+        }
+        return new LogRecord;
+    }
+
+    // 清空内容后放回缓存池，保留消息和文本缓冲区已分配的容量
+    void recycle() const {
+        auto* self = const_cast<LogRecord*>(this);
+        self->context_.message.clear();
+        self->context_.mdc.reset();
+        self->context_.fields.clear();
+        text_.reset();
+        plain_.reset();
+        if (!detail::RecordPool::instance().release(self)) {
+            delete self;
+        }
+    }
+
+    friend void intrusive_ptr_add_ref(const LogRecord* record) {
+        record->refs_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    friend void intrusive_ptr_release(const LogRecord* record) {
+        if (record->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            record->recycle();
+        }
+    }
+
+    LogContext context_{};
+    mutable std::atomic<std::uint32_t> refs_{0};
+    mutable detail::TextCache text_;
+    mutable detail::TextCache plain_;
+};
+
+// 已经格式化好的日志记录，text是用目标sink的格式化器生成的文本
+// 记录本身仍然共享，sink可以保存或者转交它而不必复制
+struct FormattedRecord {
+    RecordPtr record;
+    std::string_view text;
+
+    const LogContext& context() const {
+        return record->context();
+    }
+};
+
+} // namespace cpp_log
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "cpp_log/record.hpp"
+
+namespace cpp_log {
+
+// 按(时间戳, 序号)恢复多个生产者线程之间先后顺序的重排缓冲区
+// 同一线程的记录本来就是有序的，按线程各自放在一条流中；取出时对各条流的队首做k路归并，
+// 只取出时间戳不晚于给定截止时间的记录。调用方用"当前时间 - 重排窗口"作为截止时间，
+// 只要每条记录在窗口之内到达，取出的顺序就严格按(时间戳, 序号)递增。
+// 每条记录附带入队时间（steady_clock），取出时一并交给调用方，用于计算排队时间。
+// 不是线程安全的，由使用方保证串行访问（例如在strand上）
+class ReorderBuffer {
+public:
+    void push(RecordPtr record, std::chrono::steady_clock::time_point enqueued = {}) {
+        auto id = record->context().thread_id;
+        auto& stream = streams_[id];
+        if (stream.empty()) {
+            heads_.push(head_of(*record, id, &stream));
+        }
+        stream.push_back({std::move(record), enqueued});
+        ++size_;
+    }
+
+    // 按顺序把时间戳不晚于until的记录和它的入队时间交给emit，返回其中比之前取出的记录更早的条数
+    // （到达得太晚、已经无法排到正确位置的记录）
+    template<typename Emit>
+    std::uint64_t release(std::chrono::system_clock::time_point until, Emit&& emit) {
+        std::uint64_t late = 0;
+        while (!heads_.empty() && heads_.top().timestamp <= until) {
+            auto head = heads_.top();
+            auto item = pop_head();
+
+            std::pair key{head.timestamp, head.sequence};
+            if (released_any_ && key < last_released_) {
+                ++late;
+            } else {
+                last_released_ = key;
+                released_any_ = true;
+            }
+            emit(std::move(item.record), item.enqueued);
+        }
+        return late;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    // 缓冲区中最早一条记录的时间戳，调用前需确认不为空
+    std::chrono::system_clock::time_point oldest() const {
+        return heads_.top().timestamp;
+    }
+
+    // 丢弃最早的一条记录（队列超出容量时），调用前需确认不为空
+    void drop_oldest() {
+        pop_head();
+    }
+
+    // 缓冲区中最早入队的时间，调用前需确认不为空
+    // 同一条流按入队顺序排列，只需比较各条流的队首
+    std::chrono::steady_clock::time_point oldest_enqueued() const {
+        auto oldest = std::chrono::steady_clock::time_point::max();
+        for (const auto& [id, stream] : streams_) {
+            oldest = std::min(oldest, stream.front().enqueued);
+        }
+        return oldest;
+    }
+
+    void clear() {
+        streams_.clear();
+        heads_ = {};
+        size_ = 0;
+    }
+
+private:
+    struct Item {
+        RecordPtr record;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    using Stream = std::deque<Item>;
+
+    struct Head {
+        std::chrono::system_clock::time_point timestamp;
+        std::uint64_t sequence;
+        std::thread::id id;
+        Stream* stream;  // unordered_map的元素地址在插入其他元素时保持不变
+
+        // 用于最小堆：时间戳和序号较大的排在后面
+        bool operator<(const Head& other) const {
+            if (timestamp != other.timestamp) {
+                return timestamp > other.timestamp;
+            }
+            return sequence > other.sequence;
+        }
+    };
+
+    // 取出堆顶流的队首记录
+    Item pop_head() {
+        auto head = heads_.top();
+        heads_.pop();
+
+        auto item = std::move(head.stream->front());
+        head.stream->pop_front();
+        --size_;
+        if (!head.stream->empty()) {
+            heads_.push(head_of(*head.stream->front().record, head.id, head.stream));
+        } else {
+            streams_.erase(head.id);  // 线程退出后不再保留它的流
+        }
+        return item;
+    }
+
+    static Head head_of(const LogRecord& record, std::thread::id id, Stream* stream) {
+        return {record.context().timestamp, record.context().sequence, id, stream};
+    }
+
+    std::unordered_map<std::thread::id, Stream> streams_;
+    std::priority_queue<Head> heads_;  // 每条非空流的队首
+    size_t size_ = 0;
+    std::pair<std::chrono::system_clock::time_point, std::uint64_t> last_released_{};
+    bool released_any_ = false;
+};
+
+} // namespace cpp_log
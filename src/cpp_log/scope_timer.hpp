@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <source_location>
+#include <string_view>
+#include "cpp_log/level.hpp"
+#include "cpp_log/fields.hpp"
+
+namespace cpp_log {
+
+// 某个计时点的累计耗时，用于按周期输出汇总而不是每次都输出
+// 通常由CPP_LOG_SCOPE_TIMER_AGGREGATE在调用点定义为静态对象，各线程无锁更新
+class TimerStats {
+public:
+    struct Summary {
+        std::uint64_t count;
+        std::chrono::nanoseconds min;
+        std::chrono::nanoseconds max;
+        std::chrono::nanoseconds total;
+    };
+
+    explicit TimerStats(std::chrono::nanoseconds period = std::chrono::seconds(10))
+        : period_(period)
+        , next_report_(now_ns() + period.count()) {}
+
+    // 记录一次耗时，到了汇总时间时返回这一周期的统计并重新开始
+    // 同一周期只有一个线程能取得汇总
+    std::optional<Summary> add(std::chrono::nanoseconds elapsed, std::chrono::steady_clock::time_point now) {
+        auto ns = static_cast<std::uint64_t>(elapsed.count());
+        count_.fetch_add(1, std::memory_order_relaxed);
+        total_.fetch_add(ns, std::memory_order_relaxed);
+        update_min(ns);
+        update_max(ns);
+
+        auto now_count = to_ns(now);
+        auto next = next_report_.load(std::memory_order_relaxed);
+        if (now_count < next ||
+            !next_report_.compare_exchange_strong(next, now_count + period_.count(), std::memory_order_relaxed)) {
+            return std::nullopt;
+        }
+
+        // 各计数器分别交换，并发的add可能被计入下一周期
+        Summary summary{
+            count_.exchange(0, std::memory_order_relaxed),
+            std::chrono::nanoseconds(min_.exchange(std::numeric_limits<std::uint64_t>::max(), std::memory_order_relaxed)),
+            std::chrono::nanoseconds(max_.exchange(0, std::memory_order_relaxed)),
+            std::chrono::nanoseconds(total_.exchange(0, std::memory_order_relaxed))
+        };
+        if (summary.count == 0) {
+            return std::nullopt;
+        }
+        return summary;
+    }
+
+private:
+    static std::int64_t now_ns() {
+        return to_ns(std::chrono::steady_clock::now());
+    }
+
+    static std::int64_t to_ns(std::chrono::steady_clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    }
+
+    void update_min(std::uint64_t value) {
+        auto current = min_.load(std::memory_order_relaxed);
+        while (value < current && !min_.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    void update_max(std::uint64_t value) {
+        auto current = max_.load(std::memory_order_relaxed);
+        while (value > current && !max_.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    std::chrono::nanoseconds period_;
+    std::atomic<std::int64_t> next_report_;
+    std::atomic<std::uint64_t> count_{0};
+    std::atomic<std::uint64_t> total_{0};
+    std::atomic<std::uint64_t> min_{std::numeric_limits<std::uint64_t>::max()};
+    std::atomic<std::uint64_t> max_{0};
+};
+
+// 作用域计时器
+// 构造时读取一次steady_clock，析构时再读取一次并输出一条带elapsed_us字段的日志。
+// 该等级未启用时不读时钟也不输出。可以只在超过阈值时输出，用于发现慢路径；
+// 也可以把耗时累计到TimerStats，按周期输出一条count/min/avg/max汇总
+// Logger需要提供should_log(level)和vlog_kv(level, location, message, fields[, elapsed])，
+// BasicLogger和BasicStaticLogger都可以使用
+template<typename Logger>
+class ScopeTimer {
+public:
+    ScopeTimer(Logger& logger, Level level, std::string_view name,
+               const std::source_location& location = std::source_location::current())
+        : ScopeTimer(logger, level, name, std::chrono::nanoseconds::zero(), nullptr, location) {}
+
+    // 只在耗时达到threshold时输出
+    ScopeTimer(Logger& logger, Level level, std::string_view name, std::chrono::nanoseconds threshold,
+               const std::source_location& location = std::source_location::current())
+        : ScopeTimer(logger, level, name, threshold, nullptr, location) {}
+
+    // 累计到stats，按stats的周期输出汇总
+    ScopeTimer(Logger& logger, Level level, std::string_view name, TimerStats& stats,
+               const std::source_location& location = std::source_location::current())
+        : ScopeTimer(logger, level, name, std::chrono::nanoseconds::zero(), &stats, location) {}
+
+    ~ScopeTimer() {
+        if (!active_) {
+            return;
+        }
+        auto end = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start_);
+
+        if (stats_) {
+            if (auto summary = stats_->add(elapsed, end)) {
+                auto count = summary->count;
+                const Field fields[] = {
+                    kv("count", count),
+                    kv("min_us", to_us(summary->min)),
+                    kv("avg_us", to_us(summary->total) / static_cast<double>(count)),
+                    kv("max_us", to_us(summary->max))
+                };
+                logger_.vlog_kv(level_, location_, name_, fields);
+            }
+            return;
+        }
+
+        if (elapsed < threshold_) {
+            return;
+        }
+        const Field fields[] = {kv("elapsed_us", to_us(elapsed))};
+        logger_.vlog_kv(level_, location_, name_, fields, elapsed);
+    }
+
+    ScopeTimer(const ScopeTimer&) = delete;
+    ScopeTimer& operator=(const ScopeTimer&) = delete;
+
+private:
+    ScopeTimer(Logger& logger, Level level, std::string_view name, std::chrono::nanoseconds threshold,
+               TimerStats* stats, const std::source_location& location)
+        : logger_(logger)
+        , level_(level)
+        , name_(name)
+        , location_(location)
+        , threshold_(threshold)
+        , stats_(stats)
+        , active_(logger.should_log(level)) {
+        if (active_) {
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    static double to_us(std::chrono::nanoseconds duration) {
+        return static_cast<double>(duration.count()) / 1000.0;
+    }
+
+    Logger& logger_;
+    Level level_;
+    std::string_view name_;
+    std::source_location location_;
+    std::chrono::nanoseconds threshold_;
+    TimerStats* stats_;
+    bool active_;
+    std::chrono::steady_clock::time_point start_{};
+};
+
+} // namespace cpp_log
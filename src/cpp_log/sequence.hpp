@@ -0,0 +1,27 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace cpp_log {
+
+namespace detail {
+    // 每个线程一次从全局计数器取走的序号个数
+    inline constexpr std::uint64_t sequence_block_size = 1024;
+
+    // 分配下一个记录序号
+    // 每个线程从全局计数器按块取号，块内在本线程递增，避免所有线程争用同一个原子变量。
+    // 序号在进程内唯一、在同一线程内单调递增；不同线程之间以(时间戳, 序号)确定先后
+    inline std::uint64_t next_sequence() {
+        static std::atomic<std::uint64_t> counter{0};
+        thread_local std::uint64_t next = 0;
+        thread_local std::uint64_t end = 0;
+        if (next == end) {
+            next = counter.fetch_add(sequence_block_size, std::memory_order_relaxed) + 1;
+            end = next + sequence_block_size;
+        }
+        return next++;
+    }
+} // namespace detail
+
+} // namespace cpp_log
@@ -8,12 +8,71 @@
 #include <chrono>
 #include <ctime>
 #include <iomanip>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
 #include "cpp_log/level.hpp"
 #include "cpp_log/color.hpp"
 #include "cpp_log/formatter.hpp"
+#include "cpp_log/record.hpp"
+#include "cpp_log/disk_pressure.hpp"
 
 namespace cpp_log {
 
+// 写入文件的内容：文本去除颜色代码，二进制格式原样返回
+// 没有颜色代码时直接返回formatted，不复制；否则去除到scratch中，scratch由调用方逐条复用
+inline std::string_view file_text(const LogFormatter& formatter, std::string_view formatted, std::string& scratch) {
+    if (formatter.binary() || formatted.find('\033') == std::string_view::npos) {
+        return formatted;
+    }
+    scratch.clear();
+    color::append_without_color_codes(formatted, scratch);
+    return scratch;
+}
+
+// 把写入文件的内容追加到out：文本去除颜色代码，二进制格式原样追加
+inline void append_file_text(const LogFormatter& formatter, std::string_view formatted, std::string& out) {
+    if (formatter.binary()) {
+        out += formatted;
+    } else {
+        color::append_without_color_codes(formatted, out);
+    }
+}
+
+// 格式化一条日志写入文件的内容，生成在scratch中：二进制格式直接编码，文本就地去除颜色代码
+inline std::string_view format_file_text(LogFormatter& formatter, const LogContext& context, std::string& scratch) {
+    scratch.clear();
+    formatter.format_to(context, scratch);
+    if (!formatter.binary()) {
+        color::erase_color_codes(scratch);
+    }
+    return scratch;
+}
+
+// 一条记录写入文件的内容
+// 二进制格式每个sink只写一次，直接编码到scratch中，不经过记录的文本缓存；文本取去除颜色代码后的缓存
+inline std::string_view file_record_text(LogFormatter& formatter, const LogRecord& record, std::string& scratch) {
+    if (formatter.binary()) {
+        return format_file_text(formatter, record.context(), scratch);
+    }
+    return record.plain_text(formatter, scratch);
+}
+
+// 把一条记录写入文件的内容追加到out，二进制格式直接编码到out中，不产生中间字符串
+inline void append_file_record(LogFormatter& formatter, const LogRecord& record, std::string& out, std::string& scratch) {
+    if (formatter.binary()) {
+        formatter.format_to(record.context(), out);
+    } else {
+        out += record.plain_text(formatter, scratch);
+    }
+}
+
+// 把文本直接写入流，不经过临时字符串
+inline void write_text(std::ostream& out, std::string_view text) {
+    out.write(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
 // 日志输出基类
 class LogSink {
 public:
@@ -35,12 +94,61 @@ public:
         formatter_ = formatter;
     }
 
+    std::shared_ptr<LogFormatter> formatter() const {
+        return formatter_;
+    }
+
     virtual void write(const LogContext& context) = 0;
 
+    // 写入一条共享的日志记录，默认转给write
+    // 派生类可以直接使用记录中缓存的文本，或者保存记录本身而不是复制
+    virtual void write_record(const RecordPtr& record) {
+        write(record->context());
+    }
+
+    // 批量写入，默认逐条调用write_record；内置的控制台和文件sink把整批拼接后一次写出
+    virtual void write_batch(std::span<const RecordPtr> records) {
+        for (const auto& record : records) {
+            write_record(record);
+        }
+    }
+
+    // 批量写入已经格式化好的日志，默认忽略文本，把共享的记录整批转给write_batch
+    virtual void write_formatted_batch(std::span<const FormattedRecord> records) {
+        std::vector<RecordPtr> shared;
+        shared.reserve(records.size());
+        for (const auto& record : records) {
+            shared.push_back(record.record);
+        }
+        write_batch(shared);
+    }
+
     virtual void flush() {
         // 默认实现为空
     }
 
+    // 最近一次写入是否成功，默认总是成功
+    virtual bool healthy() const {
+        return true;
+    }
+
+    // 写入失败后尝试恢复，返回是否已恢复
+    virtual bool recover() {
+        return healthy();
+    }
+
+    // 当前负载，即队列的大致填充比例：0表示空闲，1表示已满，同步sink总是0
+    // 只读取原子计数器，不加锁，结果是近似值
+    virtual double pressure() const {
+        return 0.0;
+    }
+
+    // 写入是否会投递到io_context由后台线程完成，同步sink返回false
+    // 单线程日志记录器只在有异步sink时才需要fork闸门
+    virtual bool asynchronous() const {
+        return false;
+    }
+
 protected:
     Level level_ = Level::Debug;  // 默认记录所有日志
     std::shared_ptr<LogFormatter> formatter_;
@@ -50,7 +158,7 @@ protected:
 class ConsoleSink : public LogSink {
 public:
     ConsoleSink() {
-        formatter_ = std::make_shared<DefaultFormatter>();
+        formatter_ = shared_default_formatter();
     }
 
     void write(const LogContext& context) override {
@@ -62,34 +170,130 @@ public:
         std::cout << formatted;
     }
 
+    void write_record(const RecordPtr& record) override {
+        if (!should_log(record->context().level)) {
+            return;
+        }
+
+        write_text(std::cout, record->text(*formatter_, scratch_));
+    }
+
+    // 整批拼接到复用的缓冲区后一次写出
+    void write_batch(std::span<const RecordPtr> records) override {
+        buffer_.clear();
+        for (const auto& record : records) {
+            if (should_log(record->context().level)) {
+                buffer_ += record->text(*formatter_, scratch_);
+            }
+        }
+        write_text(std::cout, buffer_);
+    }
+
+    void write_formatted_batch(std::span<const FormattedRecord> records) override {
+        buffer_.clear();
+        for (const auto& record : records) {
+            if (should_log(record.context().level)) {
+                buffer_ += record.text;
+            }
+        }
+        write_text(std::cout, buffer_);
+    }
+
     void flush() override {
         std::cout.flush();
     }
+
+private:
+    std::string scratch_;  // 记录的文本缓存被其他格式化器占用时格式化到这里，逐条复用
+    std::string buffer_;   // 一批日志拼接后的内容，逐批复用
 };
 
 // 文件输出
 class FileSink : public LogSink {
 public:
-    FileSink(const std::string& filename) : file_(filename, std::ios::app) {
-        formatter_ = std::make_shared<DefaultFormatter>();
+    FileSink(const std::string& filename) : filename_(filename), file_(filename, std::ios::app | std::ios::binary) {
+        formatter_ = shared_default_formatter();
     }
 
     void write(const LogContext& context) override {
-        if (!should_log(context.level)) {
+        if (!should_log(context.level) || !disk_admits(context.level)) {
             return;
         }
 
-        std::string formatted = formatter_->format(context);
         // 移除颜色代码后写入文件
-        file_ << color::strip_color_codes(formatted);
+        write_text(file_, format_file_text(*formatter_, context, scratch_));
+    }
+
+    // 直接写出记录中缓存的去除颜色代码的文本，二进制格式编码到scratch_中
+    void write_record(const RecordPtr& record) override {
+        if (!should_log(record->context().level) || !disk_admits(record->context().level)) {
+            return;
+        }
+
+        write_text(file_, file_record_text(*formatter_, *record, scratch_));
+    }
+
+    // 整批拼接到复用的缓冲区后一次写出，大于流缓冲区的内容由流直接交给一次系统调用
+    void write_batch(std::span<const RecordPtr> records) override {
+        buffer_.clear();
+        for (const auto& record : records) {
+            if (should_log(record->context().level) && disk_admits(record->context().level)) {
+                append_file_record(*formatter_, *record, buffer_, scratch_);
+            }
+        }
+        write_text(file_, buffer_);
+    }
+
+    void write_formatted_batch(std::span<const FormattedRecord> records) override {
+        buffer_.clear();
+        for (const auto& record : records) {
+            if (should_log(record.context().level) && disk_admits(record.context().level)) {
+                append_file_text(*formatter_, record.text, buffer_);
+            }
+        }
+        write_text(file_, buffer_);
+    }
+
+    // 设置磁盘空间监视器，剩余空间不足时逐级丢弃低等级日志
+    void set_disk_monitor(std::shared_ptr<DiskPressureMonitor> monitor) {
+        disk_monitor_ = std::move(monitor);
+    }
+
+    // 为日志文件所在的卷创建磁盘空间监视器
+    void enable_disk_guard(DiskPressureOptions options = {}) {
+        set_disk_monitor(std::make_shared<DiskPressureMonitor>(filename_, options));
+    }
+
+    std::shared_ptr<DiskPressureMonitor> disk_monitor() const {
+        return disk_monitor_;
     }
 
     void flush() override {
         file_.flush();
     }
 
+    bool healthy() const override {
+        return file_.good();
+    }
+
+    // 重新打开文件，例如磁盘空间释放之后
+    bool recover() override {
+        file_.close();
+        file_.clear();
+        file_.open(filename_, std::ios::app | std::ios::binary);
+        return file_.good();
+    }
+
 protected:  
+    bool disk_admits(Level level) {
+        return !disk_monitor_ || disk_monitor_->admit(level);
+    }
+
+    std::string filename_;
     std::ofstream file_;
+    std::shared_ptr<DiskPressureMonitor> disk_monitor_;
+    std::string scratch_;  // 去除颜色代码或者文本缓存被占用时的临时文本，逐条复用
+    std::string buffer_;   // 一批日志拼接后的内容，逐批复用
 };
 
 // 日志轮转策略
@@ -127,41 +331,89 @@ public:
     }
 
     void write(const LogContext& context) override {
-        if (!should_log(context.level)) {
+        if (!should_log(context.level) || !disk_admits(context.level)) {
             return;
         }
 
-        std::string formatted = formatter_->format(context);
         // 移除颜色代码后计算消息大小
-        std::string stripped = color::strip_color_codes(formatted);
-        size_t msg_size = stripped.size();
+        write_one(format_file_text(*formatter_, context, scratch_));
+    }
 
-        bool should_rotate = false;
-        auto now = std::chrono::system_clock::now();
+    void write_record(const RecordPtr& record) override {
+        if (!should_log(record->context().level) || !disk_admits(record->context().level)) {
+            return;
+        }
+
+        write_one(file_record_text(*formatter_, *record, scratch_));
+    }
+
+    // 整批拼接到复用的缓冲区后一次写出，只在轮转的位置把已拼接的部分写入旧文件
+    void write_batch(std::span<const RecordPtr> records) override {
+        buffer_.clear();
+        for (const auto& record : records) {
+            if (should_log(record->context().level) && disk_admits(record->context().level)) {
+                size_t start = buffer_.size();
+                append_file_record(*formatter_, *record, buffer_, scratch_);
+                account(start);
+            }
+        }
+        write_text(file_, buffer_);
+    }
+
+    void write_formatted_batch(std::span<const FormattedRecord> records) override {
+        buffer_.clear();
+        for (const auto& record : records) {
+            if (should_log(record.context().level) && disk_admits(record.context().level)) {
+                size_t start = buffer_.size();
+                append_file_text(*formatter_, record.text, buffer_);
+                account(start);
+            }
+        }
+        write_text(file_, buffer_);
+    }
+
+private:
+    // 写入一条已去除颜色代码的日志，需要轮转时先轮转
+    void write_one(std::string_view stripped) {
+        if (needs_rotation(stripped.size())) {
+            rotate();
+        }
+        write_text(file_, stripped);
+        current_size_ += stripped.size();
+    }
+
+    // buffer_中从start开始是刚追加的一条日志，把它计入当前文件；
+    // 需要轮转时先把它之前的部分写入旧文件，再轮转，buffer_中只留下这一条
+    void account(size_t start) {
+        size_t msg_size = buffer_.size() - start;
+        if (needs_rotation(msg_size)) {
+            file_.write(buffer_.data(), static_cast<std::streamsize>(start));
+            buffer_.erase(0, start);
+            rotate();
+        }
+        current_size_ += msg_size;
+    }
 
+    // 一条大小为msg_size的日志写入当前文件之前是否需要先轮转
+    bool needs_rotation(size_t msg_size) const {
         switch (strategy_) {
             case RotationStrategy::Size:
-                should_rotate = (current_size_ + msg_size > max_size_);
-                break;
+                return current_size_ + msg_size > max_size_;
             case RotationStrategy::Daily:
             case RotationStrategy::Hourly:
-                should_rotate = (now >= next_rotation_time_);
-                break;
+                return std::chrono::system_clock::now() >= next_rotation_time_;
         }
+        return false;
+    }
 
-        if (should_rotate) {
-            rotate_files();
-            current_size_ = 0;
-            if (strategy_ != RotationStrategy::Size) {
-                calculate_next_rotation_time();
-            }
+    void rotate() {
+        rotate_files();
+        current_size_ = 0;
+        if (strategy_ != RotationStrategy::Size) {
+            calculate_next_rotation_time();
         }
-
-        file_ << stripped;
-        current_size_ += msg_size;
     }
 
-private:
     void calculate_next_rotation_time() {
         auto now = std::chrono::system_clock::now();
         auto time_t_now = std::chrono::system_clock::to_time_t(now);
@@ -191,7 +443,7 @@ private:
 
         cleanup_old_files();
 
-        file_.open(base_filename_, std::ios::out | std::ios::trunc);
+        file_.open(base_filename_, std::ios::out | std::ios::trunc | std::ios::binary);
         if (!file_.is_open()) {
             throw std::runtime_error("Failed to open new log file after rotation: " + base_filename_);
         }
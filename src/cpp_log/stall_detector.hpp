@@ -0,0 +1,132 @@
+#pragma once
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "cpp_log/backend.hpp"
+#include "cpp_log/async_sink.hpp"
+
+namespace cpp_log {
+
+namespace asio = boost::asio;
+
+// 某个sink当前的积压情况
+struct SinkLag {
+    std::string name;
+    size_t pending;               // 等待写出的日志条数
+    std::chrono::nanoseconds lag; // 最早一条未写出日志在队列中已等待的时间（steady_clock）
+};
+
+// 慢速sink检测器
+// 在自己的线程上定期检查被监控的异步sink，积压超过阈值时调用回调报告是哪个sink、落后了多少
+class StallDetector {
+public:
+    using Handler = std::function<void(const SinkLag&)>;
+
+    explicit StallDetector(std::chrono::milliseconds threshold = std::chrono::seconds(1),
+                           std::chrono::milliseconds interval = std::chrono::milliseconds(100))
+        : threshold_(threshold)
+        , interval_(interval)
+        , handler_(default_handler) {
+        asio::co_spawn(executor_.get_io_context(), check_loop(), asio::detached);
+    }
+
+    ~StallDetector() {
+        running_ = false;
+    }
+
+    // 添加需要监控的sink，只保存弱引用
+    void watch(std::string name, std::shared_ptr<AsyncLogSink> sink) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.push_back({std::move(name), sink, threshold_});
+    }
+
+    // 设置报告回调，在检测线程上调用，调用时不持有检测器的锁，回调中可以调用snapshot或watch
+    void set_handler(Handler handler) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        handler_ = std::move(handler);
+    }
+
+    // 获取所有被监控sink的当前积压情况
+    std::vector<SinkLag> snapshot() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<SinkLag> result;
+        for (const auto& entry : entries_) {
+            if (auto sink = entry.sink.lock()) {
+                result.push_back({entry.name, sink->pending(), sink->lag()});
+            }
+        }
+        return result;
+    }
+
+private:
+    struct Entry {
+        std::string name;
+        std::weak_ptr<AsyncLogSink> sink;
+        std::chrono::nanoseconds next_report;  // 下一次报告的延迟阈值，每次报告后翻倍
+    };
+
+    static void default_handler(const SinkLag& lag) {
+        std::cerr << "cpp_log: sink '" << lag.name << "' is lagging: "
+                  << lag.pending << " records pending, oldest waiting for "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(lag.lag).count() << "ms\n";
+    }
+
+    // 持有锁收集需要报告的sink，释放锁之后再调用回调
+    void check() {
+        std::vector<SinkLag> reports;
+        Handler handler;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::erase_if(entries_, [](const Entry& entry) { return entry.sink.expired(); });
+            for (auto& entry : entries_) {
+                auto sink = entry.sink.lock();
+                if (!sink) {
+                    continue;
+                }
+                auto lag = sink->lag();
+                if (lag < threshold_) {
+                    entry.next_report = threshold_;
+                } else if (lag >= entry.next_report) {
+                    reports.push_back({entry.name, sink->pending(), lag});
+                    entry.next_report = lag * 2;
+                }
+            }
+            if (!reports.empty()) {
+                handler = handler_;
+            }
+        }
+        for (const auto& report : reports) {
+            handler(report);
+        }
+    }
+
+    asio::awaitable<void> check_loop() {
+        asio::steady_timer timer(co_await asio::this_coro::executor);
+        while (running_) {
+            timer.expires_after(interval_);
+            co_await timer.async_wait(asio::use_awaitable);
+            check();
+        }
+    }
+
+    std::chrono::nanoseconds threshold_;
+    std::chrono::nanoseconds interval_;
+    mutable std::mutex mutex_;
+    std::vector<Entry> entries_;
+    Handler handler_;
+    std::atomic<bool> running_{true};
+    SinkExecutor executor_;  // 最后声明，析构时最先停止检测线程
+};
+
+} // namespace cpp_log
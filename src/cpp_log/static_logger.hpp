@@ -0,0 +1,240 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <mutex>
+#include <optional>
+#include <source_location>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "cpp_log/backend.hpp"
+#include "cpp_log/fields.hpp"
+#include "cpp_log/level.hpp"
+#include "cpp_log/formatter.hpp"
+#include "cpp_log/record.hpp"
+#include "cpp_log/probes.hpp"
+#include "cpp_log/sink.hpp"
+#include "cpp_log/threading.hpp"
+
+namespace cpp_log {
+
+// 编译期确定输出目标的日志记录器
+// 所有sink以值的形式保存在std::tuple中，通过折叠表达式逐个调用。
+// 对sink的调用都限定了具体类型（sink.Sink::write_record），不经过LogSink的虚表，
+// 等级过滤和分发可以完整内联；消息格式化仍然经过类型擦除的std::vformat，
+// 输出格式由sink持有的LogFormatter（虚函数）决定
+// 多线程版本在fork前持有锁，单线程版本在有异步sink时分发期间进入fork闸门，见detail::ForkGate
+template<typename ThreadingPolicy, typename... Sinks>
+class BasicStaticLogger : public ForkHandler {
+public:
+    using mutex_type = typename ThreadingPolicy::mutex_type;
+
+    BasicStaticLogger() {
+        register_fork_handler();
+    }
+
+    // 每个参数构造一个sink，参数个数必须与sink个数相同；
+    // 排除BasicStaticLogger自身，非const左值不会选中这里而绕过被删除的复制构造函数
+    template<typename... Args>
+        requires (sizeof...(Args) == sizeof...(Sinks)) &&
+                 (!std::is_same_v<std::remove_cvref_t<Args>, BasicStaticLogger> && ...)
+    explicit BasicStaticLogger(Args&&... sinks)
+        : sinks_(std::forward<Args>(sinks)...) {
+        register_fork_handler();
+    }
+
+    ~BasicStaticLogger() override {
+        if constexpr (!is_single_threaded) {
+            LogBackend::instance().remove_fork_handler(this);
+        }
+    }
+
+    BasicStaticLogger(const BasicStaticLogger&) = delete;
+    BasicStaticLogger& operator=(const BasicStaticLogger&) = delete;
+
+    void prepare_fork() override { mutex_.lock(); }
+    void after_fork_parent() override { mutex_.unlock(); }
+    void after_fork_child() override { mutex_.unlock(); }
+    ForkStage fork_stage() const override { return ForkStage::Lock; }
+
+    // 单线程版本在Debug模式下检查只有所有者线程在使用，默认第一次写日志或刷新的线程成为所有者。
+    // 交给另一个线程使用时在那个线程上调用一次；多线程版本什么也不做
+    void bind_to_current_thread() {
+        if constexpr (is_single_threaded) {
+            mutex_.bind_to_current_thread();
+        }
+    }
+
+    // 按索引获取输出对象
+    template<size_t I>
+    auto& sink() {
+        return std::get<I>(sinks_);
+    }
+
+    // 设置全局最小日志等级
+    void set_level(Level level) {
+        min_level_.store(level, std::memory_order_relaxed);
+    }
+
+    // 获取全局最小日志等级
+    Level level() const {
+        return min_level_.load(std::memory_order_relaxed);
+    }
+
+    // 检查是否应该记录该等级的日志，只要有一个sink接受即可
+    bool should_log(Level level) const {
+        if (level < min_level_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        return std::apply([level](const auto&... sink) {
+            return (sink.should_log(level) || ...);
+        }, sinks_);
+    }
+
+    // 所有输出目标中最高的负载，sink在编译期确定，不需要加锁
+    double pressure() const {
+        return std::apply([](const auto&... sink) {
+            return std::max({0.0, pressure_of(sink)...});
+        }, sinks_);
+    }
+
+    // 按当前负载建议的最低等级，见pressure_cutoff
+    Level pressure_level() const {
+        return pressure_cutoff(level(), pressure());
+    }
+
+    template<typename... Args>
+    void log(Level level,
+             const std::source_location& location,
+             std::format_string<Args...> fmt,
+             Args&&... args) {
+        if (!should_log(level)) {
+            return;
+        }
+
+        CPP_LOG_PROBE(log_entry, static_cast<int>(level), fmt.get().data(), fmt.get().size(),
+                      location.file_name(), location.line());
+        dispatch(LogRecord::create(level, location, fmt.get(), std::make_format_args(args...)));
+        CPP_LOG_PROBE(write_done, static_cast<int>(level), fmt.get().data(), fmt.get().size(),
+                      location.file_name(), location.line());
+    }
+
+    // 消息不经过格式化，附带结构化字段；elapsed非0时是一条计时日志
+    // 与BasicLogger::vlog_kv的签名相同，ScopeTimer通过它输出
+    void vlog_kv(Level level,
+                 const std::source_location& location,
+                 std::string_view message,
+                 std::span<const Field> fields,
+                 std::chrono::nanoseconds elapsed = std::chrono::nanoseconds::zero()) {
+        if (!should_log(level)) {
+            return;
+        }
+
+        CPP_LOG_PROBE(log_entry, static_cast<int>(level), message.data(), message.size(),
+                      location.file_name(), location.line());
+        dispatch(LogRecord::create(level, location, message, fields, elapsed));
+        CPP_LOG_PROBE(write_done, static_cast<int>(level), message.data(), message.size(),
+                      location.file_name(), location.line());
+    }
+
+    template<typename... Args>
+    void debug(const std::source_location& location, std::format_string<Args...> fmt, Args&&... args) {
+        log(Level::Debug, location, fmt, std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    void info(const std::source_location& location, std::format_string<Args...> fmt, Args&&... args) {
+        log(Level::Info, location, fmt, std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    void warn(const std::source_location& location, std::format_string<Args...> fmt, Args&&... args) {
+        log(Level::Warning, location, fmt, std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    void error(const std::source_location& location, std::format_string<Args...> fmt, Args&&... args) {
+        log(Level::Error, location, fmt, std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    void fatal(const std::source_location& location, std::format_string<Args...> fmt, Args&&... args) {
+        log(Level::Fatal, location, fmt, std::forward<Args>(args)...);
+    }
+
+    // 刷新所有输出目标
+    void flush() {
+        std::lock_guard<mutex_type> lock(mutex_);
+        std::apply([](auto&... sink) {
+            (flush_sink(sink), ...);
+        }, sinks_);
+    }
+
+private:
+    static constexpr bool is_single_threaded = std::is_same_v<ThreadingPolicy, SingleThreaded>;
+
+    // 单线程版本的sink在构造时确定，此时决定是否需要fork闸门
+    void register_fork_handler() {
+        if constexpr (!is_single_threaded) {
+            LogBackend::instance().add_fork_handler(this);
+        } else {
+            fork_gate_.set_enabled(std::apply([](const auto&... sink) {
+                return (is_asynchronous(sink) || ...);
+            }, sinks_));
+        }
+    }
+
+    void dispatch(const RecordPtr& record) {
+        std::optional<detail::ForkGateScope> gate;
+        if constexpr (is_single_threaded) {
+            if (fork_gate_.enabled()) {
+                gate.emplace(fork_gate_);
+            }
+        }
+        std::lock_guard<mutex_type> lock(mutex_);
+        // 限定调用具体类型的write_record，不经过LogSink的虚表
+        std::apply([&record](auto&... sink) {
+            (write_to(sink, record), ...);
+        }, sinks_);
+    }
+
+    // Sink是tuple中的具体类型，限定名调用不会走虚函数分发
+    template<typename Sink>
+    static void write_to(Sink& sink, const RecordPtr& record) {
+        sink.Sink::write_record(record);
+    }
+
+    template<typename Sink>
+    static void flush_sink(Sink& sink) {
+        sink.Sink::flush();
+    }
+
+    template<typename Sink>
+    static double pressure_of(const Sink& sink) {
+        return sink.Sink::pressure();
+    }
+
+    template<typename Sink>
+    static bool is_asynchronous(const Sink& sink) {
+        return sink.Sink::asynchronous();
+    }
+
+    mutex_type mutex_;
+    std::tuple<Sinks...> sinks_;
+    typename ThreadingPolicy::template atomic_type<Level> min_level_{Level::Debug};
+    [[no_unique_address]] std::conditional_t<is_single_threaded, detail::ForkGate, detail::NoForkGate> fork_gate_;
+};
+
+template<typename... Sinks>
+using StaticLogger = BasicStaticLogger<MultiThreaded, Sinks...>;
+
+template<typename... Sinks>
+using StaticLoggerST = BasicStaticLogger<SingleThreaded, Sinks...>;
+
+} // namespace cpp_log
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <mutex>
+#include <thread>
+
+namespace cpp_log {
+
+// 空互斥量，用于单线程场景，加锁解锁都不做任何事情
+// Debug模式下记录所有者线程，如果被其他线程加锁则触发断言。
+// 未调用bind_to_current_thread()时，第一次加锁的线程成为所有者
+class NullMutex {
+public:
+    // 把当前线程登记为所有者，替换之前绑定的线程
+    void bind_to_current_thread() {
+#ifndef NDEBUG
+        owner_ = std::this_thread::get_id();
+#endif
+    }
+
+    void lock() {
+        check_owner();
+    }
+
+    bool try_lock() {
+        check_owner();
+        return true;
+    }
+
+    void unlock() {}
+
+private:
+    void check_owner() {
+#ifndef NDEBUG
+        if (owner_ == std::thread::id{}) {
+            owner_ = std::this_thread::get_id();
+        }
+        assert(owner_ == std::this_thread::get_id() && "single-threaded logger used from another thread");
+#endif
+    }
+
+#ifndef NDEBUG
+    std::thread::id owner_;
+#endif
+};
+
+// 与std::atomic接口一致的普通变量，单线程下不需要原子操作
+template<typename T>
+class NullAtomic {
+public:
+    NullAtomic() = default;
+    NullAtomic(T value) : value_(value) {}
+
+    T load(std::memory_order = std::memory_order_relaxed) const {
+        return value_;
+    }
+
+    void store(T value, std::memory_order = std::memory_order_relaxed) {
+        value_ = value;
+    }
+
+private:
+    T value_{};
+};
+
+// 多线程策略：真实的互斥量和原子变量
+struct MultiThreaded {
+    using mutex_type = std::mutex;
+    template<typename T>
+    using atomic_type = std::atomic<T>;
+};
+
+// 单线程策略：空互斥量，不使用原子操作
+// 唯一的例外是有异步sink时的fork闸门，见detail::ForkGate
+struct SingleThreaded {
+    using mutex_type = NullMutex;
+    template<typename T>
+    using atomic_type = NullAtomic<T>;
+};
+
+} // namespace cpp_log
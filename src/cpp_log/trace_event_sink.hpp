@@ -0,0 +1,200 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "cpp_log/level.hpp"
+#include "cpp_log/formatter.hpp"
+#include "cpp_log/record.hpp"
+#include "cpp_log/sink.hpp"
+#include "cpp_log/json_formatter.hpp"
+
+namespace cpp_log {
+
+// Chrome trace-event输出的刷新配置
+struct TraceEventOptions {
+    size_t flush_bytes = 64 * 1024;                  // 上次刷新后写出的字节数达到该值时刷新
+    std::chrono::milliseconds flush_interval{1000};  // 距上次刷新超过该时间后，下一次写入时刷新
+};
+
+// Chrome trace-event格式的sink，输出可以直接在Perfetto UI或chrome://tracing中打开
+// 普通日志输出为瞬时事件（"ph":"i"），带耗时的记录（作用域计时器）输出为完整事件（"ph":"X"），
+// 开始时间为记录时间减去耗时。pid为当前进程，tid按LogContext.thread_id依次编号，
+// 并在首次出现时输出thread_name元数据事件，名称为线程ID文本。
+// 使用JSON数组格式逐条写出：打开时写入"["，析构时补上"]"并刷新。
+// 不调用flush()时按TraceEventOptions的字节数和时间间隔刷新，进程异常退出时最多丢失最近一段事件；
+// 此时文件缺少结尾的"]"，Perfetto和chrome://tracing仍能正常加载
+class TraceEventSink : public LogSink {
+public:
+    explicit TraceEventSink(const std::string& filename, TraceEventOptions options = {})
+        : file_(filename, std::ios::out | std::ios::trunc | std::ios::binary)
+        , options_(options)
+        , pid_(current_pid())
+        , last_flush_(std::chrono::steady_clock::now()) {
+        if (!file_) {
+            throw std::runtime_error("Failed to open trace file: " + filename);
+        }
+        file_ << "[\n";
+    }
+
+    ~TraceEventSink() override {
+        file_ << "\n]\n";
+        file_.flush();
+    }
+
+    void write(const LogContext& context) override {
+        if (!should_log(context.level)) {
+            return;
+        }
+        std::string buffer;
+        append_event(buffer, context);
+        write_buffer(buffer);
+    }
+
+    void write_batch(std::span<const RecordPtr> records) override {
+        std::string buffer;
+        for (const auto& record : records) {
+            if (should_log(record->context().level)) {
+                append_event(buffer, record->context());
+            }
+        }
+        write_buffer(buffer);
+    }
+
+    void write_formatted_batch(std::span<const FormattedRecord> records) override {
+        std::string buffer;
+        for (const auto& record : records) {
+            if (should_log(record.context().level)) {
+                append_event(buffer, record.context());
+            }
+        }
+        write_buffer(buffer);
+    }
+
+    void flush() override {
+        file_.flush();
+        unflushed_ = 0;
+        last_flush_ = std::chrono::steady_clock::now();
+    }
+
+    bool healthy() const override {
+        return file_.good();
+    }
+
+private:
+    // 写出一段事件，达到字节数或时间间隔时刷新
+    void write_buffer(const std::string& buffer) {
+        if (buffer.empty()) {
+            return;
+        }
+        file_.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        unflushed_ += buffer.size();
+        if (unflushed_ >= options_.flush_bytes ||
+            std::chrono::steady_clock::now() - last_flush_ >= options_.flush_interval) {
+            flush();
+        }
+    }
+
+    static std::int64_t current_pid() {
+#if defined(_WIN32)
+        return static_cast<std::int64_t>(::_getpid());
+#else
+        return static_cast<std::int64_t>(::getpid());
+#endif
+    }
+
+    // 追加一个事件，每个事件占一行，除第一个外以",\n"开头
+    void append_event(std::string& out, const LogContext& context) {
+        auto tid = thread_index(out, context.thread_id);
+        auto end = std::chrono::duration_cast<std::chrono::nanoseconds>(context.timestamp.time_since_epoch());
+
+        separator(out);
+        out += "{\"name\":";
+        detail::append_json_string(out, context.message);
+        out += ",\"cat\":\"";
+        out += get_level_string(context.level);
+        if (context.elapsed.count() > 0) {
+            out += "\",\"ph\":\"X\",\"ts\":";
+            append_micros(out, end - context.elapsed);
+            out += ",\"dur\":";
+            append_micros(out, context.elapsed);
+        } else {
+            out += "\",\"ph\":\"i\",\"s\":\"t\",\"ts\":";
+            append_micros(out, end);
+        }
+        std::format_to(std::back_inserter(out), ",\"pid\":{},\"tid\":{},\"args\":{{\"file\":", pid_, tid);
+        detail::append_json_string(out, context.location.file_name());
+        std::format_to(std::back_inserter(out), ",\"line\":{},\"seq\":{}", context.location.line(), context.sequence);
+
+        for (const MdcFrame* frame = context.mdc.get(); frame; frame = frame->parent.get()) {
+            if (mdc_find(context.mdc, frame->key) != &frame->value) {
+                continue;  // 被内层同名key覆盖
+            }
+            out += ',';
+            detail::append_json_string(out, frame->key);
+            out += ':';
+            detail::append_json_mdc_value(out, frame->value);
+        }
+        for (const auto& field : context.fields) {
+            out += ',';
+            detail::append_json_string(out, field.key);
+            out += ':';
+            detail::append_json_value(out, field);
+        }
+        out += "}}";
+    }
+
+    // 线程ID映射为从1开始的编号，首次出现时输出thread_name元数据事件
+    std::int64_t thread_index(std::string& out, std::thread::id id) {
+        auto [it, inserted] = threads_.try_emplace(id, static_cast<std::int64_t>(threads_.size() + 1));
+        if (inserted) {
+            separator(out);
+            std::format_to(std::back_inserter(out),
+                "{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":{},\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}",
+                pid_, it->second, detail::thread_id_text(id));
+        }
+        return it->second;
+    }
+
+    void separator(std::string& out) {
+        if (!first_event_) {
+            out += ",\n";
+        }
+        first_event_ = false;
+    }
+
+    // trace-event的时间单位是微秒，保留纳秒精度输出三位小数
+    static void append_micros(std::string& out, std::chrono::nanoseconds value) {
+        auto ns = value.count();
+        if (ns < 0) {
+            out += '-';
+            ns = -ns;
+        }
+        std::format_to(std::back_inserter(out), "{}.{:03}", ns / 1000, ns % 1000);
+    }
+
+    std::ofstream file_;
+    TraceEventOptions options_;
+    std::int64_t pid_;
+    size_t unflushed_ = 0;  // 上次刷新后写出的字节数
+    std::chrono::steady_clock::time_point last_flush_;
+    std::unordered_map<std::thread::id, std::int64_t> threads_;
+    bool first_event_ = true;
+};
+
+} // namespace cpp_log
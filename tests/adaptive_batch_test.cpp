@@ -0,0 +1,110 @@
+// 自适应批量：默认指标名每个sink不同，重新启用时指标保留，sink析构后指标注销；
+// 到达速率低、max_delay内凑不够一批时不暂留
+#include <cpp_log/async_sink.hpp>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "check.hpp"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+// 记录每条日志从创建到写出的延迟
+class LatencySink : public cpp_log::LogSink {
+public:
+    void write(const cpp_log::LogContext& context) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        latencies_.push_back(std::chrono::system_clock::now() - context.timestamp);
+    }
+
+    std::vector<std::chrono::system_clock::duration> latencies() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return latencies_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<std::chrono::system_clock::duration> latencies_;
+};
+
+bool has_gauge(const std::string& name) {
+    auto metrics = cpp_log::Metrics::instance().snapshot();
+    return std::any_of(metrics.begin(), metrics.end(), [&](const auto& entry) { return entry.first == name; });
+}
+
+size_t batch_gauges() {
+    auto metrics = cpp_log::Metrics::instance().snapshot();
+    return std::count_if(metrics.begin(), metrics.end(), [](const auto& entry) {
+        return entry.first.starts_with("async_sink.") && entry.first.ends_with(".batch_size");
+    });
+}
+
+// 启用后每个sink一组指标，重新启用时替换掉的状态不会注销新状态的指标
+void gauges_released() {
+    {
+        cpp_log::AsyncSinkAdapter first(std::make_shared<LatencySink>());
+        cpp_log::AsyncSinkAdapter second(std::make_shared<LatencySink>());
+        first.enable_adaptive_batching();
+        second.enable_adaptive_batching();
+        CPP_LOG_CHECK(batch_gauges() == 2);
+        CPP_LOG_CHECK(!has_gauge("async_sink.batch_size"));
+
+        second.enable_adaptive_batching();
+        std::this_thread::sleep_for(50ms);
+        CPP_LOG_CHECK(batch_gauges() == 2);
+
+        second.disable_adaptive_batching();
+        std::this_thread::sleep_for(50ms);
+        CPP_LOG_CHECK(batch_gauges() == 1);
+    }
+    CPP_LOG_CHECK(batch_gauges() == 0);
+
+    // 循环创建sink时注册表不会增长
+    for (int i = 0; i < 100; ++i) {
+        cpp_log::AsyncSinkAdapter sink(std::make_shared<LatencySink>());
+        sink.enable_adaptive_batching();
+    }
+    auto metrics = cpp_log::Metrics::instance().snapshot();
+    CPP_LOG_CHECK(std::none_of(metrics.begin(), metrics.end(), [](const auto& entry) {
+        return entry.first.starts_with("async_sink.");
+    }));
+}
+
+// 到达速率低时不暂留
+void low_rate_not_held() {
+    auto target = std::make_shared<LatencySink>();
+    cpp_log::AsyncSinkAdapter first(target);
+    first.set_wait_strategy(cpp_log::WaitStrategy::Block);
+    first.enable_adaptive_batching({.name = {}, .min_batch = 16, .max_batch = 4096, .max_delay = 200ms});
+
+    // 每20ms一条，200ms内只到达10条，凑不够16条的批量，每条都应立即写出而不是等满200ms
+    for (int i = 0; i < 20; ++i) {
+        cpp_log::LogContext context{};
+        context.level = cpp_log::Level::Info;
+        context.timestamp = std::chrono::system_clock::now();
+        first.write(context);
+        std::this_thread::sleep_for(20ms);
+    }
+    auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (target->latencies().size() < 20 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    auto latencies = target->latencies();
+    CPP_LOG_CHECK(latencies.size() == 20);
+    for (auto latency : latencies) {
+        CPP_LOG_CHECK(latency < 100ms);
+    }
+}
+
+} // namespace
+
+int main() {
+    gauges_released();
+    low_rate_not_held();
+    return 0;
+}
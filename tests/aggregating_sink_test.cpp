@@ -0,0 +1,115 @@
+// 聚合输出：析构时写出最后一个周期的汇总并在调用线程上释放输出目标，
+// 之后后台协程醒来也不能再访问它；析构取消汇总定时器，协程不等到下一个周期就退出并释放状态；
+// 两个线程同时占用同一个调用点的槽位时都不等待，每条日志只计入调用点或overflow之一
+#include <cpp_log/aggregating_sink.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <future>
+#include <map>
+#include <memory>
+#include <source_location>
+#include <string>
+#include <thread>
+#include "check.hpp"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+using Summary = std::map<std::string, std::uint64_t>;
+
+Summary summary_fields(const cpp_log::LogContext& context) {
+    Summary fields;
+    for (const auto& field : context.fields) {
+        fields[std::string(field.key)] = field.as_uint();
+    }
+    return fields;
+}
+
+} // namespace
+
+int main() {
+    std::atomic<int> summaries{0};
+    std::atomic<int> forwarded{0};
+    for (int iteration = 0; iteration < 50; ++iteration) {
+        auto output = std::make_shared<cpp_log_test::CaptureSink<>>([&](const cpp_log::LogContext& context) {
+            ++(context.message == "log summary" ? summaries : forwarded);
+            return context.message;
+        });
+        std::weak_ptr<cpp_log::LogSink> weak_output = output;
+        int before = summaries;
+        {
+            cpp_log::AggregatingOptions options;
+            options.interval = 1ms;
+            cpp_log::AggregatingSink sink(std::move(output), options);
+            cpp_log::LogContext context{};
+            context.level = cpp_log::Level::Info;
+            sink.write(context);
+            context.level = cpp_log::Level::Error;
+            sink.write(context);
+            std::this_thread::sleep_for(std::chrono::microseconds(iteration * 40));
+        }
+        // 计数已经汇总，输出目标随sink一起释放，不等汇总协程退出
+        CPP_LOG_CHECK(weak_output.expired());
+        CPP_LOG_CHECK(summaries > before);
+    }
+    CPP_LOG_CHECK(forwarded == 50);
+
+    // 周期很长时析构也不留下等待中的定时器：独立的io_context在汇总协程退出、状态释放后run()即返回
+    boost::asio::io_context ioc;
+    auto output = std::make_shared<cpp_log_test::CaptureSink<>>();
+    std::weak_ptr<cpp_log::LogSink> weak_output = output;
+    std::future<size_t> ran;
+    {
+        cpp_log::AggregatingOptions options;
+        options.interval = 1h;
+        cpp_log::AggregatingSink sink(std::move(output), options, ioc);
+        ran = std::async(std::launch::async, [&ioc] { return ioc.run(); });
+        cpp_log::LogContext context{};
+        context.level = cpp_log::Level::Info;
+        sink.write(context);
+        std::this_thread::sleep_for(10ms);
+    }
+    CPP_LOG_CHECK(weak_output.expired());
+    CPP_LOG_CHECK(ran.wait_for(5s) == std::future_status::ready);
+    CPP_LOG_CHECK(ran.get() > 0);
+
+    // 两个线程同时从同一个调用点写入，槽位由其中一个占用，另一个不等待
+    constexpr int per_thread = 1000;
+    const auto location = std::source_location::current();
+    const auto callsite = std::format("{}:{}", location.file_name(), location.line());
+    for (int iteration = 0; iteration < 200; ++iteration) {
+        auto summaries_sink = std::make_shared<cpp_log_test::CaptureSink<Summary>>(summary_fields);
+        cpp_log::AggregatingOptions options;
+        options.interval = 1h;
+        cpp_log::AggregatingSink sink(summaries_sink, options);
+        std::atomic<bool> start{false};
+        auto producer = [&] {
+            cpp_log::LogContext context{};
+            context.level = cpp_log::Level::Info;
+            context.location = location;
+            while (!start.load(std::memory_order_acquire)) {
+            }
+            for (int i = 0; i < per_thread; ++i) {
+                sink.write(context);
+            }
+        };
+        std::thread first(producer);
+        std::thread second(producer);
+        start.store(true, std::memory_order_release);
+        first.join();
+        second.join();
+        sink.report_now();
+
+        auto entries = summaries_sink->entries();
+        CPP_LOG_CHECK(entries.size() == 1);
+        auto& fields = entries.front();
+        CPP_LOG_CHECK(fields["total"] == 2 * per_thread);
+        CPP_LOG_CHECK(fields["INFO"] == 2 * per_thread);
+        CPP_LOG_CHECK(fields[callsite] > 0);
+        CPP_LOG_CHECK(fields[callsite] + fields["overflow"] == 2 * per_thread);
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+// 异步sink在后台线程上析构：最后一个引用在io_context的工作线程中释放时，
+// 析构函数无法等待处理循环，必须保证之后处理循环和已投递的任务都不再访问sink。
+// 配合-fsanitize=address或thread运行可以发现释放后访问
+#include <cpp_log/log.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <atomic>
+#include <future>
+#include <memory>
+#include "check.hpp"
+
+namespace {
+
+// do_write真正挂起的sink：每条日志在定时器上等待一段时间后才算写出
+class SuspendingSink : public cpp_log::AsyncLogSink {
+public:
+    explicit SuspendingSink(std::atomic<size_t>& written)
+        : written_(written) {}
+
+    ~SuspendingSink() override {
+        shutdown();
+    }
+
+protected:
+    boost::asio::awaitable<void> do_write(const std::string& message, cpp_log::Level level) override {
+        boost::asio::steady_timer timer(co_await boost::asio::this_coro::executor, std::chrono::microseconds(200));
+        co_await timer.async_wait(boost::asio::use_awaitable);
+        written_.fetch_add(1);
+    }
+
+private:
+    std::atomic<size_t>& written_;
+};
+
+}  // namespace
+
+int main() {
+    cpp_log::BackendOptions options;
+    options.thread_count = 2;
+    cpp_log::LogBackend::instance().configure(options);
+    auto& ioc = cpp_log::LogBackend::instance().get_io_context();
+
+    auto target = std::make_shared<cpp_log_test::CaptureSink<>>();
+    for (int iteration = 0; iteration < 300; ++iteration) {
+        auto sink = std::make_shared<cpp_log::AsyncSinkAdapter>(target);
+        if (iteration % 3 == 1) {
+            sink->set_wait_strategy(cpp_log::WaitStrategy::Spin);
+        } else if (iteration % 3 == 2) {
+            sink->enable_adaptive_batching({.name = "teardown_test"});
+        }
+        for (int i = 0; i < 50; ++i) {
+            sink->write(cpp_log::LogContext{});
+        }
+
+        // 最后一个引用在后台工作线程上释放
+        std::promise<void> released;
+        boost::asio::post(ioc, [sink = std::move(sink), &released]() mutable {
+            sink.reset();
+            released.set_value();
+        });
+        CPP_LOG_CHECK(released.get_future().wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+    }
+
+    // 在调用线程上析构时必须写完全部日志
+    {
+        auto target = std::make_shared<cpp_log_test::CaptureSink<>>();
+        auto sink = std::make_shared<cpp_log::AsyncSinkAdapter>(target);
+        for (int i = 0; i < 1000; ++i) {
+            sink->write(cpp_log::LogContext{});
+        }
+        sink.reset();
+        CPP_LOG_CHECK(target->size() == 1000);
+    }
+
+    // do_write挂起期间strand继续执行其他任务：入队和flush不能阻塞在处理循环上
+    {
+        std::atomic<size_t> written{0};
+        auto sink = std::make_shared<SuspendingSink>(written);
+        for (int i = 0; i < 200; ++i) {
+            sink->write(cpp_log::LogContext{});
+            if (i % 50 == 49) {
+                sink->flush();
+                CPP_LOG_CHECK(written.load() == static_cast<size_t>(i + 1));
+            }
+        }
+        for (int i = 0; i < 100; ++i) {
+            sink->write(cpp_log::LogContext{});
+        }
+        sink.reset();
+        CPP_LOG_CHECK(written.load() == 300);
+    }
+    return 0;
+}
@@ -0,0 +1,289 @@
+// 批量写入接口：
+// - LogSink::write_batch默认逐条转给write_record，write_formatted_batch把共享的记录整批转给write_batch
+// - 异步sink收到格式化好的批次时直接写出其中的文本，不再格式化
+// - 异步sink按批交给被包装sink的write_batch，顺序不变、每批不超过batch_size；
+//   FlushPolicy::EveryRecord时逐条写入，不调用write_batch
+// - FileSink和RotatingFileSink整批拼接到复用的缓冲区后一次写出，等级过滤对每条单独生效；
+//   RotatingFileSink只在轮转的位置把一批分开，轮转前的部分写入旧文件
+// - 二进制格式化器直接编码到文件sink的缓冲区，不调用format()，也不占用记录的文本缓存
+#include <cpp_log/async_sink.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <source_location>
+#include <string>
+#include <vector>
+#include "check.hpp"
+
+namespace {
+
+using Target = cpp_log_test::CaptureSink<>;
+
+cpp_log::RecordPtr make_record(cpp_log::Level level, std::string_view message) {
+    return cpp_log::LogRecord::create(level, std::source_location::current(), message,
+                                      std::span<const cpp_log::Field>{});
+}
+
+void submit(cpp_log::AsyncLogSink& sink, std::string message) {
+    sink.write_record(make_record(cpp_log::Level::Info, message));
+}
+
+// 记录每次write_batch收到的条数
+class BatchRecordingSink : public Target {
+public:
+    void write_batch(std::span<const cpp_log::RecordPtr> records) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            batches_.push_back(records.size());
+        }
+        Target::write_batch(records);
+    }
+
+    std::vector<size_t> batches() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return batches_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<size_t> batches_;
+};
+
+// 统计格式化次数，只输出消息
+class CountingFormatter : public cpp_log::LogFormatter {
+public:
+    std::string format(const cpp_log::LogContext& context) override {
+        calls.fetch_add(1);
+        return context.message + "\n";
+    }
+
+    std::atomic<int> calls{0};
+};
+
+// 二进制格式：消息后跟一个0字节，format()只用于统计是否经过了中间字符串
+class BinaryFormatter : public cpp_log::LogFormatter {
+public:
+    std::string format(const cpp_log::LogContext& context) override {
+        calls.fetch_add(1);
+        std::string out;
+        format_to(context, out);
+        return out;
+    }
+
+    void format_to(const cpp_log::LogContext& context, std::string& out) override {
+        out += context.message;
+        out += '\0';
+    }
+
+    bool binary() const override {
+        return true;
+    }
+
+    std::atomic<int> calls{0};
+};
+
+// 保存记录用格式化器生成（或缓存）的文本
+class TextSink : public Target {
+public:
+    explicit TextSink(std::shared_ptr<cpp_log::LogFormatter> formatter) {
+        formatter_ = std::move(formatter);
+    }
+
+    void write_record(const cpp_log::RecordPtr& record) override {
+        std::string scratch;
+        add(std::string(record->text(*formatter_, scratch)));
+    }
+};
+
+std::vector<std::string> numbers(int count) {
+    std::vector<std::string> result;
+    for (int i = 0; i < count; ++i) {
+        result.push_back(std::to_string(i));
+    }
+    return result;
+}
+
+void default_batch() {
+    BatchRecordingSink target;
+    std::vector<cpp_log::RecordPtr> records{
+        make_record(cpp_log::Level::Info, "a"),
+        make_record(cpp_log::Level::Info, "b"),
+        make_record(cpp_log::Level::Info, "c")};
+    target.write_batch(records);
+    CPP_LOG_CHECK((target.entries() == std::vector<std::string>{"a", "b", "c"}));
+
+    std::vector<cpp_log::FormattedRecord> formatted;
+    for (const auto& record : records) {
+        formatted.push_back({record, "ignored"});
+    }
+    target.write_formatted_batch(formatted);
+    CPP_LOG_CHECK((target.entries() == std::vector<std::string>{"a", "b", "c", "a", "b", "c"}));
+    CPP_LOG_CHECK((target.batches() == std::vector<size_t>{3, 3}));
+}
+
+// 异步sink写出格式化好的文本，被包装的sink从记录缓存中取到它，格式化器一次也不调用
+void async_formatted() {
+    auto formatter = std::make_shared<CountingFormatter>();
+    auto target = std::make_shared<TextSink>(formatter);
+    target->set_level(cpp_log::Level::Info);
+    std::vector<cpp_log::RecordPtr> records{
+        make_record(cpp_log::Level::Info, "a"),
+        make_record(cpp_log::Level::Debug, "filtered"),
+        make_record(cpp_log::Level::Warning, "b")};
+    std::vector<cpp_log::FormattedRecord> formatted{
+        {records[0], "first\n"},
+        {records[1], "filtered\n"},
+        {records[2], "second\n"}};
+    {
+        cpp_log::AsyncSinkAdapter sink(target);
+        CPP_LOG_CHECK(sink.formatter() == formatter);
+        sink.write_formatted_batch(formatted);
+        sink.flush();
+    }
+    CPP_LOG_CHECK((target->entries() == std::vector<std::string>{"first\n", "second\n"}));
+    CPP_LOG_CHECK(formatter->calls.load() == 0);
+}
+
+// 输出卡住期间入队的日志在恢复后按批写出
+void async_batches(cpp_log::FlushPolicy policy) {
+    constexpr int count = 20;
+    constexpr size_t batch_size = 6;
+    auto target = std::make_shared<BatchRecordingSink>();
+    {
+        cpp_log::AsyncSinkAdapter sink(target);
+        sink.set_batch_size(batch_size);
+        sink.set_flush_policy(policy);
+        target->hold();
+        submit(sink, "0");
+        target->wait_blocked();
+        for (int i = 1; i < count; ++i) {
+            submit(sink, std::to_string(i));
+        }
+        target->release();
+        sink.flush();
+    }
+    CPP_LOG_CHECK(target->entries() == numbers(count));
+
+    auto batches = target->batches();
+    if (policy == cpp_log::FlushPolicy::EveryRecord) {
+        CPP_LOG_CHECK(batches.empty());
+        return;
+    }
+    size_t total = 0;
+    for (size_t size : batches) {
+        CPP_LOG_CHECK(size >= 1 && size <= batch_size);
+        total += size;
+    }
+    CPP_LOG_CHECK(total == count);
+    CPP_LOG_CHECK(*std::max_element(batches.begin(), batches.end()) == batch_size);
+}
+
+std::string read_file(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+template<typename Sink, typename... Args>
+void file_batch(const std::string& name, Args... args) {
+    auto path = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove(path);
+    {
+        std::ofstream create(path);
+    }
+    {
+        Sink sink(path.string(), args...);
+        sink.set_formatter(std::make_shared<cpp_log::PatternFormatter>("%m"));
+        sink.set_level(cpp_log::Level::Info);
+        std::vector<cpp_log::RecordPtr> records{
+            make_record(cpp_log::Level::Info, "first"),
+            make_record(cpp_log::Level::Debug, "filtered"),
+            make_record(cpp_log::Level::Error, "second")};
+        sink.write_batch(records);
+
+        std::vector<cpp_log::FormattedRecord> formatted{
+            {records[0], "third\n"},
+            {records[1], "filtered\n"}};
+        sink.write_formatted_batch(formatted);
+        sink.flush();
+    }
+    CPP_LOG_CHECK(read_file(path) == "first\nsecond\nthird\n");
+    std::filesystem::remove(path);
+}
+
+template<typename Sink, typename... Args>
+void binary_batch(const std::string& name, Args... args) {
+    auto path = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove(path);
+    {
+        std::ofstream create(path);
+    }
+    auto formatter = std::make_shared<BinaryFormatter>();
+    std::vector<cpp_log::RecordPtr> records{
+        make_record(cpp_log::Level::Info, "a"),
+        make_record(cpp_log::Level::Info, "b\033[31m"),
+        make_record(cpp_log::Level::Info, "c")};
+    {
+        Sink sink(path.string(), args...);
+        sink.set_formatter(formatter);
+        sink.write_batch(std::span(records).first(2));
+        sink.write_record(records[2]);
+        sink.flush();
+    }
+    CPP_LOG_CHECK(read_file(path) == std::string("a\0b\033[31m\0c\0", 11));
+    CPP_LOG_CHECK(formatter->calls.load() == 0);
+
+    // 文本缓存仍然空着，留给之后的文本格式化器
+    cpp_log::PatternFormatter text_formatter("%m");
+    std::string scratch;
+    for (const auto& record : records) {
+        CPP_LOG_CHECK(record->text(text_formatter, scratch).data() != scratch.data());
+    }
+    std::filesystem::remove(path);
+}
+
+// 每个文件最多两条日志，一批五条跨过两次轮转
+void rotating_batch_split() {
+    auto path = std::filesystem::temp_directory_path() / "cpp_log_batch_write_split_test.log";
+    auto rotated = std::filesystem::path(path.string() + ".1");
+    std::filesystem::remove(path);
+    std::filesystem::remove(rotated);
+    {
+        std::ofstream create(path);
+    }
+    {
+        cpp_log::RotatingFileSink sink(path.string(), 7, 2);
+        sink.set_formatter(std::make_shared<cpp_log::PatternFormatter>("%m"));
+        std::vector<cpp_log::RecordPtr> records;
+        for (int i = 0; i < 5; ++i) {
+            records.push_back(make_record(cpp_log::Level::Info, "r" + std::to_string(i)));
+        }
+        sink.write_batch(records);
+        sink.flush();
+    }
+    // 最后一次轮转把r2、r3移到.1，r0、r1所在的文件被它覆盖
+    CPP_LOG_CHECK(read_file(rotated) == "r2\nr3\n");
+    CPP_LOG_CHECK(read_file(path) == "r4\n");
+    std::filesystem::remove(path);
+    std::filesystem::remove(rotated);
+}
+
+} // namespace
+
+int main() {
+    default_batch();
+    async_formatted();
+    async_batches(cpp_log::FlushPolicy::EveryBatch);
+    async_batches(cpp_log::FlushPolicy::EveryRecord);
+    file_batch<cpp_log::FileSink>("cpp_log_batch_write_test.log");
+    file_batch<cpp_log::RotatingFileSink>("cpp_log_batch_write_rotating_test.log", size_t{1 << 20}, size_t{2});
+    rotating_batch_split();
+    binary_batch<cpp_log::FileSink>("cpp_log_batch_write_binary_test.log");
+    binary_batch<cpp_log::RotatingFileSink>("cpp_log_batch_write_binary_rotating_test.log", size_t{1 << 20}, size_t{2});
+    binary_batch<cpp_log::AsyncFileSink>("cpp_log_batch_write_binary_async_test.log");
+    return 0;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cpp_log/sink.hpp>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 测试用的断言，失败时输出位置并以非0状态退出
+#define CPP_LOG_CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            std::exit(1); \
+        } \
+    } while (0)
+
+namespace cpp_log_test {
+
+// 收集write()看到的日志的输出目标，线程安全
+// capture把每条日志转换成要保存的Entry，转换在写入线程上执行；默认用LogContext构造Entry，
+// Entry不能由LogContext构造时保存消息文本。
+// hold()之后的写入阻塞到release()，用来模拟卡住的输出
+template<typename Entry = std::string>
+class CaptureSink : public cpp_log::LogSink {
+public:
+    using Capture = std::function<Entry(const cpp_log::LogContext&)>;
+
+    explicit CaptureSink(Capture capture = default_capture())
+        : capture_(std::move(capture)) {}
+
+    void write(const cpp_log::LogContext& context) override {
+        add(capture_(context));
+    }
+
+    std::vector<Entry> entries() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_;
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.size();
+    }
+
+    bool contains(const Entry& entry) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return std::find(entries_.begin(), entries_.end(), entry) != entries_.end();
+    }
+
+    void hold() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        held_ = true;
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        held_ = false;
+        changed_.notify_all();
+    }
+
+    // 等到有一个写入阻塞在hold()上
+    void wait_blocked() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [this] { return blocked_ > 0; });
+    }
+
+    // 等到收集了至少count条，超时返回false
+    bool wait_for_size(size_t count, std::chrono::milliseconds timeout = std::chrono::seconds(30)) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return changed_.wait_for(lock, timeout, [&] { return entries_.size() >= count; });
+    }
+
+protected:
+    // 派生类重写其他写入接口时用它保存
+    void add(Entry entry) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (held_) {
+            ++blocked_;
+            changed_.notify_all();
+            changed_.wait(lock, [this] { return !held_; });
+            --blocked_;
+        }
+        entries_.push_back(std::move(entry));
+        changed_.notify_all();
+    }
+
+private:
+    static Capture default_capture() {
+        if constexpr (std::is_constructible_v<Entry, const cpp_log::LogContext&>) {
+            return [](const cpp_log::LogContext& context) { return Entry(context); };
+        } else if constexpr (std::is_constructible_v<Entry, const std::string&>) {
+            return [](const cpp_log::LogContext& context) { return Entry(context.message); };
+        } else {
+            return nullptr;
+        }
+    }
+
+    Capture capture_;
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    std::vector<Entry> entries_;
+    bool held_ = false;
+    size_t blocked_ = 0;
+};
+
+} // namespace cpp_log_test
@@ -0,0 +1,31 @@
+# 检查可执行文件的.note.stapsdt中登记了cpp_log的各个探针
+# cmake -DREADELF=<readelf> -DBINARY=<可执行文件> [-DMIN_CALLSITES=<n>] -P check_usdt_notes.cmake
+execute_process(
+    COMMAND ${READELF} -n ${BINARY}
+    OUTPUT_VARIABLE notes
+    RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "readelf -n ${BINARY} failed")
+endif()
+
+string(FIND "${notes}" ".note.stapsdt" section)
+if(section EQUAL -1)
+    message(FATAL_ERROR "${BINARY} has no .note.stapsdt section")
+endif()
+
+foreach(probe callsite log_entry write_done async_written)
+    string(REGEX MATCH "Provider: cpp_log[ \t\r\n]+Name: ${probe}[ \t\r\n]" found "${notes}")
+    if(NOT found)
+        message(FATAL_ERROR "${BINARY} has no USDT probe cpp_log:${probe}")
+    endif()
+endforeach()
+
+# callsite探针在CPP_LOG_*宏展开处登记，每个调用点至少一条；
+# MIN_CALLSITES为程序中CPP_LOG_*宏调用点的个数
+if(DEFINED MIN_CALLSITES)
+    string(REGEX MATCHALL "Provider: cpp_log[ \t\r\n]+Name: callsite[ \t\r\n]" callsites "${notes}")
+    list(LENGTH callsites count)
+    if(count LESS MIN_CALLSITES)
+        message(FATAL_ERROR "${BINARY} has ${count} cpp_log:callsite probes, expected at least ${MIN_CALLSITES}")
+    endif()
+endif()
@@ -0,0 +1,29 @@
+# 同一批日志分别用MsgpackFormatter和JsonFormatter输出，msgpack2json转换后必须与后者逐字节相同
+# cmake -DGENERATOR=<cpp_log_msgpack_records> -DCONVERTER=<cpp_log_msgpack2json> -DWORK_DIR=<目录>
+#       -P compare_msgpack2json.cmake
+file(MAKE_DIRECTORY ${WORK_DIR})
+set(msgpack_file ${WORK_DIR}/records.msgpack)
+set(json_file ${WORK_DIR}/records.jsonl)
+set(converted_file ${WORK_DIR}/converted.jsonl)
+
+execute_process(
+    COMMAND ${GENERATOR} ${msgpack_file} ${json_file} 6000
+    RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${GENERATOR} failed")
+endif()
+
+execute_process(
+    COMMAND ${CONVERTER} ${msgpack_file}
+    OUTPUT_FILE ${converted_file}
+    RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${CONVERTER} failed")
+endif()
+
+execute_process(
+    COMMAND ${CMAKE_COMMAND} -E compare_files ${converted_file} ${json_file}
+    RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${converted_file} differs from ${json_file}")
+endif()
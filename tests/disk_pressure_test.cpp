@@ -0,0 +1,154 @@
+// 磁盘空间保护：剩余空间越过各阈值时逐级丢弃低等级日志，空间恢复后重新写入；
+// 监视器析构时取消后台定时器，检查协程不会继续持有状态
+#include <cpp_log/sink.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include "check.hpp"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr std::uint64_t MiB = 1024ull * 1024;
+
+template<typename Predicate>
+bool wait_until(Predicate predicate, std::chrono::milliseconds timeout = 5s) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!predicate()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(1ms);
+    }
+    return true;
+}
+
+// 剩余空间由测试设置
+cpp_log::DiskPressureOptions fake_options(std::shared_ptr<std::atomic<std::uint64_t>> space) {
+    cpp_log::DiskPressureOptions options;
+    options.warning_below = 1024 * MiB;
+    options.error_below = 512 * MiB;
+    options.stop_below = 128 * MiB;
+    options.check_interval = 2ms;
+    options.space_probe = [space](const std::filesystem::path&) -> std::optional<std::uint64_t> {
+        return space->load();
+    };
+    return options;
+}
+
+void log(cpp_log::LogSink& sink, cpp_log::Level level, const std::string& message) {
+    cpp_log::LogContext context{};
+    context.level = level;
+    context.timestamp = std::chrono::system_clock::now();
+    context.message = message;
+    sink.write(context);
+}
+
+void thresholds() {
+    auto space = std::make_shared<std::atomic<std::uint64_t>>(4096 * MiB);
+    cpp_log::DiskPressureMonitor monitor(".", fake_options(space));
+    CPP_LOG_CHECK(monitor.min_level() == cpp_log::Level::Debug);
+    CPP_LOG_CHECK(monitor.admit(cpp_log::Level::Debug));
+
+    space->store(600 * MiB);
+    CPP_LOG_CHECK(wait_until([&] { return monitor.min_level() == cpp_log::Level::Warning; }));
+    CPP_LOG_CHECK(!monitor.admit(cpp_log::Level::Info));
+    CPP_LOG_CHECK(monitor.admit(cpp_log::Level::Warning));
+
+    space->store(200 * MiB);
+    CPP_LOG_CHECK(wait_until([&] { return monitor.min_level() == cpp_log::Level::Error; }));
+    CPP_LOG_CHECK(!monitor.admit(cpp_log::Level::Warning));
+    CPP_LOG_CHECK(monitor.admit(cpp_log::Level::Error));
+
+    space->store(64 * MiB);
+    CPP_LOG_CHECK(wait_until([&] { return !monitor.writing(); }));
+    CPP_LOG_CHECK(!monitor.admit(cpp_log::Level::Fatal));
+    CPP_LOG_CHECK(monitor.available() == 64 * MiB);
+
+    CPP_LOG_CHECK(monitor.dropped(cpp_log::Level::Info) == 1);
+    CPP_LOG_CHECK(monitor.dropped(cpp_log::Level::Warning) == 1);
+    CPP_LOG_CHECK(monitor.dropped(cpp_log::Level::Fatal) == 1);
+    CPP_LOG_CHECK(monitor.dropped() == 3);
+
+    // 空间恢复后所有等级重新写入
+    space->store(4096 * MiB);
+    CPP_LOG_CHECK(wait_until([&] { return monitor.min_level() == cpp_log::Level::Debug; }));
+    CPP_LOG_CHECK(monitor.writing());
+    CPP_LOG_CHECK(monitor.admit(cpp_log::Level::Debug));
+    CPP_LOG_CHECK(monitor.dropped() == 3);
+}
+
+std::string read_file(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void file_sink() {
+    auto path = std::filesystem::temp_directory_path() / "cpp_log_disk_pressure_test.log";
+    std::filesystem::remove(path);
+    auto space = std::make_shared<std::atomic<std::uint64_t>>(4096 * MiB);
+    {
+        cpp_log::FileSink sink(path.string());
+        auto monitor = std::make_shared<cpp_log::DiskPressureMonitor>(path, fake_options(space));
+        sink.set_disk_monitor(monitor);
+
+        log(sink, cpp_log::Level::Info, "before");
+        space->store(64 * MiB);
+        CPP_LOG_CHECK(wait_until([&] { return !monitor->writing(); }));
+        log(sink, cpp_log::Level::Info, "shed info");
+        log(sink, cpp_log::Level::Fatal, "shed fatal");
+        space->store(4096 * MiB);
+        CPP_LOG_CHECK(wait_until([&] { return monitor->writing(); }));
+        log(sink, cpp_log::Level::Info, "after");
+        sink.flush();
+        CPP_LOG_CHECK(monitor->dropped() == 2);
+    }
+
+    auto text = read_file(path);
+    CPP_LOG_CHECK(text.find("before") != std::string::npos);
+    CPP_LOG_CHECK(text.find("after") != std::string::npos);
+    CPP_LOG_CHECK(text.find("shed") == std::string::npos);
+    std::filesystem::remove(path);
+}
+
+// 路径无法stat（文件名超过NAME_MAX）时按文件处理，检查其所在目录而不是抛异常
+void unreadable_path() {
+    auto directory = std::filesystem::temp_directory_path();
+    cpp_log::DiskPressureOptions options;
+    options.space_probe = [directory](const std::filesystem::path& path) -> std::optional<std::uint64_t> {
+        return path == directory ? 4096 * MiB : 0;
+    };
+    cpp_log::DiskPressureMonitor monitor(directory / std::string(4096, 'x'), std::move(options));
+    CPP_LOG_CHECK(monitor.available() == 4096 * MiB);
+}
+
+// 检查间隔很长，只有取消定时器才能让协程在析构后立即释放状态（以及其中的space_probe）
+void cancelled_on_destruction() {
+    auto space = std::make_shared<std::atomic<std::uint64_t>>(4096 * MiB);
+    std::weak_ptr<std::atomic<std::uint64_t>> weak_space = space;
+    {
+        auto options = fake_options(std::move(space));
+        options.check_interval = std::chrono::hours(1);
+        cpp_log::DiskPressureMonitor monitor(".", std::move(options));
+        std::this_thread::sleep_for(20ms);
+    }
+    CPP_LOG_CHECK(wait_until([&] { return weak_space.expired(); }));
+}
+
+} // namespace
+
+int main() {
+    thresholds();
+    file_sink();
+    unreadable_path();
+    cancelled_on_destruction();
+    return 0;
+}
@@ -0,0 +1,219 @@
+// 故障转移：卡住的目标不能阻塞生产者，写入失败的日志补写到下一个目标，
+// 目标恢复并且积压写完之后切换回去；flush返回时已提交的日志已经写出；
+// sink析构后目标不能由后台协程持有；计数器从注册表中移除之后sink照常工作
+#include <cpp_log/failover_sink.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include "check.hpp"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+// 记录收到的消息；hang为true时写入一直阻塞，ok为false时写入失败
+class TestSink : public cpp_log::LogSink {
+public:
+    void write(const cpp_log::LogContext& context) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        resumed_.wait(lock, [this] { return !hang_; });
+        if (ok_) {
+            messages_.insert(context.message);
+        }
+        failed_ = !ok_;
+    }
+
+    bool healthy() const override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return !failed_;
+    }
+
+    bool recover() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        failed_ = !ok_;
+        return ok_;
+    }
+
+    void set_hang(bool hang) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        hang_ = hang;
+        resumed_.notify_all();
+    }
+
+    void set_ok(bool ok) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ok_ = ok;
+    }
+
+    std::set<std::string> messages() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return messages_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable resumed_;
+    bool hang_ = false;
+    bool ok_ = true;
+    bool failed_ = false;
+    std::set<std::string> messages_;
+};
+
+void log(cpp_log::LogSink& sink, int i) {
+    cpp_log::LogContext context{};
+    context.level = cpp_log::Level::Info;
+    context.timestamp = std::chrono::system_clock::now();
+    context.message = std::to_string(i);
+    sink.write(context);
+}
+
+template<typename Predicate>
+bool wait_until(Predicate predicate, std::chrono::milliseconds timeout = 5s) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!predicate()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(1ms);
+    }
+    return true;
+}
+
+cpp_log::FailoverOptions test_options(const std::string& name) {
+    cpp_log::FailoverOptions options;
+    options.name = name;
+    options.latency_threshold = 20ms;
+    options.check_interval = 2ms;
+    options.probe_interval = 20ms;
+    return options;
+}
+
+// 所有日志至少写到了其中一个目标
+bool all_written(const TestSink& primary, const TestSink& backup, int count) {
+    auto first = primary.messages();
+    auto second = backup.messages();
+    for (int i = 0; i < count; ++i) {
+        auto message = std::to_string(i);
+        if (!first.contains(message) && !second.contains(message)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void hung_target() {
+    auto primary = std::make_shared<TestSink>();
+    auto backup = std::make_shared<TestSink>();
+    auto& metrics = cpp_log::Metrics::instance();
+    cpp_log::FailoverSink sink({primary, backup}, test_options("hung"));
+
+    primary->set_hang(true);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 5000; ++i) {
+        log(sink, i);
+        if (i == 0) {
+            CPP_LOG_CHECK(wait_until([&] { return sink.active_index() == 1; }));
+        }
+    }
+    // 生产者只入队，不会等待卡住的目标
+    CPP_LOG_CHECK(std::chrono::steady_clock::now() - start < 2s);
+    CPP_LOG_CHECK(metrics.counter("hung.failovers").value() == 1);
+    CPP_LOG_CHECK(wait_until([&] { return backup->messages().size() == 4999; }));
+
+    // 卡住期间积压的日志写完且探测通过之后才切换回去
+    primary->set_hang(false);
+    CPP_LOG_CHECK(wait_until([&] { return sink.active_index() == 0; }));
+    CPP_LOG_CHECK(metrics.counter("hung.recoveries").value() == 1);
+    CPP_LOG_CHECK(primary->messages().contains("0"));
+    log(sink, 5000);
+    CPP_LOG_CHECK(wait_until([&] { return all_written(*primary, *backup, 5001); }));
+}
+
+void failing_target() {
+    auto primary = std::make_shared<TestSink>();
+    auto backup = std::make_shared<TestSink>();
+    auto& metrics = cpp_log::Metrics::instance();
+    cpp_log::FailoverSink sink({primary, backup}, test_options("failing"));
+
+    primary->set_ok(false);
+    for (int i = 0; i < 1000; ++i) {
+        log(sink, i);
+    }
+    // 写入失败的日志都补写到了备用目标
+    CPP_LOG_CHECK(wait_until([&] { return all_written(*primary, *backup, 1000); }));
+    CPP_LOG_CHECK(sink.active_index() == 1);
+    CPP_LOG_CHECK(metrics.counter("failing.failovers").value() == 1);
+
+    // 探测时recover()成功后切换回去
+    std::this_thread::sleep_for(100ms);
+    CPP_LOG_CHECK(sink.active_index() == 1);
+    primary->set_ok(true);
+    CPP_LOG_CHECK(wait_until([&] { return sink.active_index() == 0; }));
+    CPP_LOG_CHECK(metrics.counter("failing.recoveries").value() == 1);
+
+    // 计数器从注册表中移除之后sink照常切换
+    metrics.remove("failing.failovers");
+    metrics.remove("failing.recoveries");
+    primary->set_ok(false);
+    log(sink, 1000);
+    CPP_LOG_CHECK(wait_until([&] { return sink.active_index() == 1; }));
+    CPP_LOG_CHECK(wait_until([&] { return all_written(*primary, *backup, 1001); }));
+}
+
+void flush_writes_through() {
+    auto primary = std::make_shared<TestSink>();
+    auto backup = std::make_shared<TestSink>();
+    // 机器繁忙时积压可能超过20ms而切换到备用目标，这里只检查flush，放宽阈值
+    auto options = test_options("flushed");
+    options.latency_threshold = 10s;
+    cpp_log::FailoverSink sink({primary, backup}, options);
+    for (int i = 0; i < 1000; ++i) {
+        log(sink, i);
+    }
+    // 不需要等待，flush返回时全部写到了当前目标
+    sink.flush();
+    CPP_LOG_CHECK(primary->messages().size() == 1000);
+
+    // 异步sink暂留的日志也在flush时写出
+    auto target = std::make_shared<TestSink>();
+    cpp_log::AsyncSinkAdapter async(target);
+    async.set_reorder_window(std::chrono::hours(1));
+    async.enable_adaptive_batching({.name = "flushed", .min_batch = 1024, .max_batch = 4096, .max_delay = 1s});
+    for (int i = 0; i < 10; ++i) {
+        log(async, i);
+    }
+    async.flush();
+    CPP_LOG_CHECK(target->messages().size() == 10);
+    CPP_LOG_CHECK(async.pending() == 0);
+}
+
+void released_on_destruction() {
+    auto primary = std::make_shared<TestSink>();
+    auto backup = std::make_shared<TestSink>();
+    std::weak_ptr<TestSink> weak_primary = primary;
+    std::weak_ptr<TestSink> weak_backup = backup;
+    {
+        cpp_log::FailoverSink sink({std::move(primary), std::move(backup)}, test_options("released"));
+        for (int i = 0; i < 100; ++i) {
+            log(sink, i);
+        }
+    }
+    // 后台协程还在定时器上等待，目标已经在析构函数中释放
+    CPP_LOG_CHECK(weak_primary.expired());
+    CPP_LOG_CHECK(weak_backup.expired());
+}
+
+} // namespace
+
+int main() {
+    hung_target();
+    failing_target();
+    flush_writes_through();
+    released_on_destruction();
+    return 0;
+}
@@ -0,0 +1,103 @@
+// 结构化字段：kv()按值的类型编码，char是一个字符的字符串；
+// FieldList编码后逐个读回；logfmt需要时加引号，所有控制字符都转义
+#include <cpp_log/fields.hpp>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "check.hpp"
+
+namespace {
+
+enum class Side : std::uint8_t { Buy = 1, Sell = 2 };
+
+std::string logfmt(std::initializer_list<cpp_log::Field> fields) {
+    cpp_log::FieldList list;
+    for (const auto& field : fields) {
+        list.append(field);
+    }
+    return cpp_log::to_logfmt(list);
+}
+
+void value_types() {
+    CPP_LOG_CHECK(cpp_log::kv("b", true).type == cpp_log::FieldType::Bool);
+    CPP_LOG_CHECK(cpp_log::kv("i", -5).type == cpp_log::FieldType::Int);
+    CPP_LOG_CHECK(cpp_log::kv("i", -5).as_int() == -5);
+    CPP_LOG_CHECK(cpp_log::kv("u", 5u).type == cpp_log::FieldType::UInt);
+    CPP_LOG_CHECK(cpp_log::kv("e", Side::Sell).type == cpp_log::FieldType::UInt);
+    CPP_LOG_CHECK(cpp_log::kv("e", Side::Sell).as_uint() == 2);
+    CPP_LOG_CHECK(cpp_log::kv("d", 1.5f).type == cpp_log::FieldType::Double);
+    CPP_LOG_CHECK(cpp_log::kv("s", "text").as_string() == "text");
+
+    // char是字符，不是整数
+    char c = 'x';
+    auto field = cpp_log::kv("c", c);
+    CPP_LOG_CHECK(field.type == cpp_log::FieldType::String);
+    CPP_LOG_CHECK(field.as_string() == "x");
+    CPP_LOG_CHECK(logfmt({cpp_log::kv("c", 'x')}) == "c=x");
+    CPP_LOG_CHECK(logfmt({cpp_log::kv("c", ' ')}) == "c=\" \"");
+    // signed char和unsigned char按整数处理
+    CPP_LOG_CHECK(cpp_log::kv("sc", static_cast<signed char>(-3)).as_int() == -3);
+    CPP_LOG_CHECK(cpp_log::kv("uc", static_cast<unsigned char>(200)).as_uint() == 200);
+}
+
+void round_trip() {
+    std::string key(70000, 'k');  // key超过65535字节时截断
+    const cpp_log::Field fields[] = {
+        cpp_log::kv("bool", false),
+        cpp_log::kv("int", std::numeric_limits<std::int64_t>::min()),
+        cpp_log::kv("uint", std::numeric_limits<std::uint64_t>::max()),
+        cpp_log::kv("double", -0.25),
+        cpp_log::kv("empty", ""),
+        cpp_log::kv(key, std::string_view("v\0w", 3)),
+    };
+    cpp_log::FieldList list;
+    for (const auto& field : fields) {
+        list.append(field);
+    }
+    std::vector<cpp_log::Field> decoded(list.begin(), list.end());
+    CPP_LOG_CHECK(decoded.size() == 6);
+    CPP_LOG_CHECK(decoded[0].key == "bool" && !decoded[0].as_bool());
+    CPP_LOG_CHECK(decoded[1].as_int() == std::numeric_limits<std::int64_t>::min());
+    CPP_LOG_CHECK(decoded[2].as_uint() == std::numeric_limits<std::uint64_t>::max());
+    CPP_LOG_CHECK(decoded[3].as_double() == -0.25);
+    CPP_LOG_CHECK(decoded[4].type == cpp_log::FieldType::String && decoded[4].as_string().empty());
+    CPP_LOG_CHECK(decoded[5].key.size() == 65535);
+    CPP_LOG_CHECK(decoded[5].as_string() == std::string_view("v\0w", 3));
+}
+
+void logfmt_quoting() {
+    CPP_LOG_CHECK(logfmt({cpp_log::kv("a", 1), cpp_log::kv("b", true), cpp_log::kv("c", "plain")}) ==
+                  "a=1 b=true c=plain");
+    CPP_LOG_CHECK(logfmt({cpp_log::kv("s", "")}) == "s=\"\"");
+    CPP_LOG_CHECK(logfmt({cpp_log::kv("s", "two words")}) == "s=\"two words\"");
+    CPP_LOG_CHECK(logfmt({cpp_log::kv("s", "a=b")}) == "s=\"a=b\"");
+    CPP_LOG_CHECK(logfmt({cpp_log::kv("s", "say \"hi\"\\")}) == "s=\"say \\\"hi\\\"\\\\\"");
+    CPP_LOG_CHECK(logfmt({cpp_log::kv("s", "a\nb\rc\td")}) == "s=\"a\\nb\\rc\\td\"");
+
+    // 其余控制字符也要转义，不能原样写出
+    std::string controls;
+    for (char c = 0; c < 0x20; ++c) {
+        controls += c;
+    }
+    auto text = logfmt({cpp_log::kv("s", controls)});
+    for (char c : text) {
+        CPP_LOG_CHECK(static_cast<unsigned char>(c) >= 0x20);
+    }
+    CPP_LOG_CHECK(text.starts_with("s=\"\\u0000\\u0001"));
+    CPP_LOG_CHECK(text.find("\\u0008\\t\\n\\u000b\\u000c\\r\\u000e") != std::string::npos);
+    CPP_LOG_CHECK(text.ends_with("\\u001e\\u001f\""));
+    CPP_LOG_CHECK(logfmt({cpp_log::kv("s", "bell\x07")}) == "s=\"bell\\u0007\"");
+    // UTF-8原样保留
+    CPP_LOG_CHECK(logfmt({cpp_log::kv("s", "\xC3\xA9")}) == "s=\xC3\xA9");
+}
+
+} // namespace
+
+int main() {
+    value_types();
+    round_trip();
+    logfmt_quoting();
+    return 0;
+}
@@ -0,0 +1,186 @@
+// 在持续写日志的同时反复fork：父子进程都不能死锁，父进程提交的日志一条不丢、不重复
+// 覆盖的情况：
+// - 独立执行器先于日志记录器注册，生产者持有日志记录器的锁并在Block策略下等待队列腾出空间
+// - 单线程日志记录器（LoggerST、StaticLoggerST）在另一个线程上写日志
+// - 子进程继承父进程的队列后仍然可以正常写日志
+// - 后台线程的CPU亲和性无法设置时，fork回调不抛出异常，父子进程的后台线程不绑定、继续运行
+#include <cpp_log/log.hpp>
+#include <sched.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include "check.hpp"
+
+namespace {
+
+constexpr int producer_count = 3;
+constexpr int records_per_producer = 20000;
+constexpr int fork_count = 20;
+
+using CollectingSink = cpp_log_test::CaptureSink<>;
+
+// 父进程中每个生产者的消息必须恰好各出现一次
+void check_complete(const std::vector<std::string>& messages, const std::string& prefix, int producers) {
+    std::vector<std::vector<int>> seen(producers, std::vector<int>(records_per_producer, 0));
+    for (const auto& message : messages) {
+        int producer = 0;
+        int index = 0;
+        if (message.rfind(prefix, 0) != 0 ||
+            std::sscanf(message.c_str() + prefix.size(), "%d %d", &producer, &index) != 2) {
+            continue;
+        }
+        CPP_LOG_CHECK(producer >= 0 && producer < producers);
+        CPP_LOG_CHECK(index >= 0 && index < records_per_producer);
+        ++seen[producer][index];
+    }
+    for (const auto& counts : seen) {
+        for (int count : counts) {
+            CPP_LOG_CHECK(count == 1);
+        }
+    }
+}
+
+// 等待子进程退出，超时视为死锁
+bool wait_child(pid_t pid, int& status) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (::waitpid(pid, &status, WNOHANG) == pid) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ::kill(pid, SIGKILL);
+    ::waitpid(pid, &status, 0);
+    return false;
+}
+
+// 绑定到不存在的CPU：configure重启线程时抛出异常，已经启动的线程照常运行；
+// 之后fork时同样的设置在fork回调中失败，只报告到stderr
+void fork_with_invalid_affinity() {
+    auto& backend = cpp_log::LogBackend::instance();
+    cpp_log::BackendOptions options;
+    options.cpu_affinity = {CPU_SETSIZE - 1};
+    bool threw = false;
+    try {
+        backend.configure(options);
+    } catch (const std::system_error&) {
+        threw = true;
+    }
+    CPP_LOG_CHECK(threw);
+    CPP_LOG_CHECK(backend.thread_count() == 1);
+
+    auto collector = std::make_shared<CollectingSink>();
+    cpp_log::Logger logger;
+    logger.add_sink(std::make_shared<cpp_log::AsyncSinkAdapter>(collector));
+
+    pid_t pid = ::fork();
+    CPP_LOG_CHECK(pid >= 0);
+    if (pid == 0) {
+        logger.info(std::source_location::current(), "unpinned child");
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!collector->contains("unpinned child")) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                ::_exit(2);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        ::_exit(0);
+    }
+    int status = 0;
+    CPP_LOG_CHECK(wait_child(pid, status));
+    CPP_LOG_CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    logger.info(std::source_location::current(), "unpinned parent");
+    logger.clear_sinks();
+    CPP_LOG_CHECK(collector->contains("unpinned parent"));
+    backend.configure(cpp_log::BackendOptions{});
+}
+
+} // namespace
+
+int main() {
+    ::alarm(120);  // 父进程死锁时由SIGALRM结束测试
+
+    // 独立执行器在日志记录器之前注册fork处理
+    auto collector = std::make_shared<CollectingSink>();
+    auto sink = std::make_shared<cpp_log::AsyncSinkAdapter>(cpp_log::dedicated_executor, collector);
+    sink->set_capacity(64);
+    sink->set_overflow_policy(cpp_log::OverflowPolicy::Block);
+
+    cpp_log::Logger logger;
+    logger.add_sink(sink);
+
+    auto st_collector = std::make_shared<CollectingSink>();
+    auto static_collector = std::make_shared<CollectingSink>();
+
+    std::atomic<bool> started{false};
+    std::vector<std::thread> producers;
+    for (int p = 0; p < producer_count; ++p) {
+        producers.emplace_back([&, p]() {
+            started = true;
+            for (int i = 0; i < records_per_producer; ++i) {
+                logger.info(std::source_location::current(), "mt {} {}", p, i);
+            }
+        });
+    }
+    // 单线程日志记录器只能在一个线程中使用，创建、写日志和析构都在这个线程中
+    // 异步sink放在堆上：子进程中其他线程的栈会被新线程复用，留在栈上的sink在子进程里不再有效
+    producers.emplace_back([&]() {
+        cpp_log::LoggerST st_logger;
+        st_logger.add_sink(std::make_shared<cpp_log::AsyncSinkAdapter>(st_collector));
+        auto static_logger = std::make_unique<cpp_log::StaticLoggerST<cpp_log::AsyncSinkAdapter>>(static_collector);
+        for (int i = 0; i < records_per_producer; ++i) {
+            st_logger.info(std::source_location::current(), "st {} {}", 0, i);
+            static_logger->info(std::source_location::current(), "st {} {}", 0, i);
+        }
+    });
+    while (!started) {
+        std::this_thread::yield();
+    }
+
+    for (int f = 0; f < fork_count; ++f) {
+        pid_t pid = ::fork();
+        CPP_LOG_CHECK(pid >= 0);
+        if (pid == 0) {
+            // 子进程：继承的队列已被丢弃，新写的日志要能写出
+            auto message = "child " + std::to_string(f);
+            logger.info(std::source_location::current(), "{}", message);
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (!collector->contains(message)) {
+                if (std::chrono::steady_clock::now() >= deadline) {
+                    ::_exit(2);
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            ::_exit(0);
+        }
+
+        int status = 0;
+        CPP_LOG_CHECK(wait_child(pid, status));
+        CPP_LOG_CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    // 析构时写完队列中剩余的日志
+    logger.clear_sinks();
+    sink.reset();
+
+    check_complete(collector->entries(), "mt ", producer_count);
+    check_complete(st_collector->entries(), "st ", 1);
+    check_complete(static_collector->entries(), "st ", 1);
+
+    fork_with_invalid_affinity();
+    return 0;
+}
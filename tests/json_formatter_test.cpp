@@ -0,0 +1,134 @@
+// JsonFormatter的转义：随机生成含任意字节、控制字符、不完整UTF-8以及长ASCII段的消息、
+// 诊断上下文和字段，每行必须是一个合法的JSON对象，解码后的字符串必须等于原文
+// （非法的UTF-8字节替换为U+FFFD）。CMake同时以CPP_LOG_NO_SSE2编译一份，
+// 两种实现都与同一个参考结果比较，也就保证了输出一致
+// 用法：cpp_log_json_formatter_test [条数] [随机种子]
+#include <cpp_log/log.hpp>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "check.hpp"
+#include "json_reader.hpp"
+
+namespace {
+
+using cpp_log_test::JsonReader;
+using cpp_log_test::JsonValue;
+using cpp_log_test::sanitize;
+
+// 随机文本：长ASCII段（覆盖16字节块的各种边界）、需要转义的字符、合法和不完整的UTF-8、任意字节
+std::string random_text(std::mt19937& rng, size_t max_segments) {
+    static constexpr std::string_view valid[] = {"\xC3\xA9", "\xE4\xB8\xAD", "\xF0\x9F\x98\x80", "\xED\x9F\xBF"};
+    static constexpr std::string_view invalid[] = {"\xC3", "\xE4\xB8", "\xF0\x9F\x98", "\xC0\xAF", "\xED\xA0\x80",
+                                                   "\xF4\x90\x80\x80", "\x80", "\xFF", "\xE0\x80\xAF"};
+    std::string text;
+    size_t segments = rng() % (max_segments + 1);
+    for (size_t i = 0; i < segments; ++i) {
+        switch (rng() % 6) {
+            case 0: {
+                size_t length = rng() % 48;
+                for (size_t j = 0; j < length; ++j) {
+                    text += static_cast<char>(0x20 + rng() % 0x5F);
+                }
+                break;
+            }
+            case 1: text += "\"\\\n\t\r\b\f"[rng() % 7]; break;
+            case 2: text += static_cast<char>(rng() % 0x20); break;
+            case 3: text += valid[rng() % std::size(valid)]; break;
+            case 4: text += invalid[rng() % std::size(invalid)]; break;
+            default: text += static_cast<char>(rng() % 256); break;
+        }
+    }
+    return text;
+}
+
+const JsonValue& member(const JsonValue& object, std::string_view key) {
+    const JsonValue* value = object.find(key);
+    CPP_LOG_CHECK(value != nullptr);
+    return *value;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000;
+    std::mt19937 rng(argc > 2 ? static_cast<std::uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 20240601u);
+
+    cpp_log::JsonFormatter formatter;
+    for (size_t i = 0; i < count; ++i) {
+        auto message = random_text(rng, 12);
+        auto mdc_key = random_text(rng, 3);
+        auto mdc_value = random_text(rng, 6);
+        auto field_key = random_text(rng, 3);
+        auto field_value = random_text(rng, 6);
+        double number = (i % 3 == 0) ? std::numeric_limits<double>::quiet_NaN()
+                      : (i % 3 == 1) ? std::numeric_limits<double>::infinity() : 0.25 * static_cast<double>(i);
+
+        std::optional<cpp_log::LogScope> outer;
+        std::optional<cpp_log::LogScope> inner;
+        if (i % 2 == 0) {
+            outer.emplace("request", "outer");
+            inner.emplace(mdc_key, mdc_value);
+        }
+        const cpp_log::Field fields[] = {
+            cpp_log::kv("string", field_value),
+            cpp_log::kv(field_key, static_cast<std::int64_t>(i)),
+            cpp_log::kv("double", number),
+        };
+        auto record = cpp_log::LogRecord::create(cpp_log::Level::Info, std::source_location::current(),
+                                                 message, fields);
+        auto line = formatter.format(record->context());
+
+        // JSON Lines：只在末尾有一个换行
+        CPP_LOG_CHECK(line.size() >= 2 && line.ends_with("}\n"));
+        CPP_LOG_CHECK(line.find('\n') == line.size() - 1);
+        JsonValue root;
+        JsonReader reader(std::string_view(line).substr(0, line.size() - 1));
+        if (!reader.parse_document(root)) {
+            std::fprintf(stderr, "record %zu is not valid JSON: %s", i, line.c_str());
+            return 1;
+        }
+
+        CPP_LOG_CHECK(root.kind == JsonValue::Kind::Object);
+        CPP_LOG_CHECK(member(root, "msg").text == sanitize(message));
+        CPP_LOG_CHECK(member(root, "level").text == "INFO");
+        CPP_LOG_CHECK(member(root, "seq").kind == JsonValue::Kind::Number);
+
+        const auto& field_values = member(root, "fields");
+        CPP_LOG_CHECK(member(field_values, "string").text == sanitize(field_value));
+        if (sanitize(field_key) != "string" && sanitize(field_key) != "double") {
+            CPP_LOG_CHECK(member(field_values, sanitize(field_key)).text == std::to_string(i));
+        }
+        const auto& double_value = member(field_values, "double");
+        if (std::isfinite(number)) {
+            CPP_LOG_CHECK(double_value.kind == JsonValue::Kind::Number);
+        } else {
+            CPP_LOG_CHECK(double_value.kind == JsonValue::Kind::Literal && double_value.text == "null");
+        }
+
+        if (i % 2 == 0) {
+            const auto& mdc = member(root, "mdc");
+            CPP_LOG_CHECK(member(mdc, sanitize(mdc_key)).text == sanitize(mdc_value));
+            if (sanitize(mdc_key) != "request") {
+                CPP_LOG_CHECK(member(mdc, "request").text == "outer");
+            }
+        } else {
+            CPP_LOG_CHECK(root.find("mdc") == nullptr);
+        }
+    }
+
+#ifdef CPP_LOG_JSON_SSE2
+    std::printf("%zu records checked (SSE2)\n", count);
+#else
+    std::printf("%zu records checked (scalar)\n", count);
+#endif
+    return 0;
+}
@@ -0,0 +1,282 @@
+#pragma once
+
+// 测试共用的JSON解析器：只接受合法的JSON，用于检查格式化器和sink的输出
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace cpp_log_test {
+
+// 按RFC 3629逐字符解码，非法的字节替换为U+FFFD，与格式化器的实现相互独立
+inline std::string sanitize(std::string_view text) {
+    std::string out;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        auto lead = static_cast<unsigned char>(text[pos]);
+        size_t length = lead < 0x80 ? 1 : lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 0;
+        std::uint32_t code = length == 1 ? lead : length == 2 ? lead & 0x1F : length == 3 ? lead & 0x0F : lead & 0x07;
+        bool valid = length != 0 && pos + length <= text.size();
+        for (size_t i = 1; valid && i < length; ++i) {
+            auto byte = static_cast<unsigned char>(text[pos + i]);
+            valid = (byte & 0xC0) == 0x80;
+            code = (code << 6) | (byte & 0x3F);
+        }
+        static constexpr std::uint32_t minimum[] = {0, 0, 0x80, 0x800, 0x10000};
+        valid = valid && code >= minimum[length] && code <= 0x10FFFF && (code < 0xD800 || code > 0xDFFF);
+        if (valid) {
+            out.append(text.substr(pos, length));
+            pos += length;
+        } else {
+            out += "\xEF\xBF\xBD";
+            ++pos;
+        }
+    }
+    return out;
+}
+
+// 最小的JSON解析器，只接受合法的JSON，字符串解码为UTF-8
+struct JsonValue {
+    enum class Kind { Object, Array, String, Number, Literal } kind = Kind::Literal;
+    std::string text;  // 字符串的内容、数字或字面量的原文
+    std::vector<std::pair<std::string, JsonValue>> members;
+    std::vector<JsonValue> elements;
+
+    const JsonValue* find(std::string_view key) const {
+        for (const auto& [name, value] : members) {
+            if (name == key) {
+                return &value;
+            }
+        }
+        return nullptr;
+    }
+};
+
+class JsonReader {
+public:
+    explicit JsonReader(std::string_view text) : text_(text) {}
+
+    bool parse_document(JsonValue& value) {
+        if (!parse_value(value)) {
+            return false;
+        }
+        skip_whitespace();
+        return pos_ == text_.size();
+    }
+
+private:
+    void skip_whitespace() {
+        while (pos_ < text_.size() && (text_[pos_] == ' ' || text_[pos_] == '\t' ||
+                                       text_[pos_] == '\n' || text_[pos_] == '\r')) {
+            ++pos_;
+        }
+    }
+
+    bool parse_value(JsonValue& value) {
+        skip_whitespace();
+        if (pos_ >= text_.size()) {
+            return false;
+        }
+        char c = text_[pos_];
+        if (c == '{') {
+            value.kind = JsonValue::Kind::Object;
+            return parse_object(value);
+        }
+        if (c == '[') {
+            value.kind = JsonValue::Kind::Array;
+            return parse_array(value);
+        }
+        if (c == '"') {
+            value.kind = JsonValue::Kind::String;
+            return parse_string(value.text);
+        }
+        for (std::string_view literal : {"null", "true", "false"}) {
+            if (text_.substr(pos_, literal.size()) == literal) {
+                value.kind = JsonValue::Kind::Literal;
+                value.text = literal;
+                pos_ += literal.size();
+                return true;
+            }
+        }
+        value.kind = JsonValue::Kind::Number;
+        return parse_number(value.text);
+    }
+
+    bool parse_object(JsonValue& value) {
+        ++pos_;
+        skip_whitespace();
+        if (pos_ < text_.size() && text_[pos_] == '}') {
+            ++pos_;
+            return true;
+        }
+        while (true) {
+            std::string key;
+            JsonValue member;
+            skip_whitespace();
+            if (pos_ >= text_.size() || text_[pos_] != '"' || !parse_string(key)) {
+                return false;
+            }
+            skip_whitespace();
+            if (pos_ >= text_.size() || text_[pos_++] != ':' || !parse_value(member)) {
+                return false;
+            }
+            value.members.emplace_back(std::move(key), std::move(member));
+            skip_whitespace();
+            if (pos_ >= text_.size()) {
+                return false;
+            }
+            char c = text_[pos_++];
+            if (c == '}') {
+                return true;
+            }
+            if (c != ',') {
+                return false;
+            }
+        }
+    }
+
+    bool parse_array(JsonValue& value) {
+        ++pos_;
+        skip_whitespace();
+        if (pos_ < text_.size() && text_[pos_] == ']') {
+            ++pos_;
+            return true;
+        }
+        while (true) {
+            JsonValue element;
+            if (!parse_value(element)) {
+                return false;
+            }
+            value.elements.push_back(std::move(element));
+            skip_whitespace();
+            if (pos_ >= text_.size()) {
+                return false;
+            }
+            char c = text_[pos_++];
+            if (c == ']') {
+                return true;
+            }
+            if (c != ',') {
+                return false;
+            }
+        }
+    }
+
+    bool parse_number(std::string& out) {
+        size_t start = pos_;
+        if (pos_ < text_.size() && text_[pos_] == '-') {
+            ++pos_;
+        }
+        auto digits = [&] {
+            size_t begin = pos_;
+            while (pos_ < text_.size() && text_[pos_] >= '0' && text_[pos_] <= '9') {
+                ++pos_;
+            }
+            return pos_ > begin;
+        };
+        if (!digits()) {
+            return false;
+        }
+        if (pos_ < text_.size() && text_[pos_] == '.') {
+            ++pos_;
+            if (!digits()) {
+                return false;
+            }
+        }
+        if (pos_ < text_.size() && (text_[pos_] == 'e' || text_[pos_] == 'E')) {
+            ++pos_;
+            if (pos_ < text_.size() && (text_[pos_] == '+' || text_[pos_] == '-')) {
+                ++pos_;
+            }
+            if (!digits()) {
+                return false;
+            }
+        }
+        out = text_.substr(start, pos_ - start);
+        return true;
+    }
+
+    bool parse_string(std::string& out) {
+        ++pos_;
+        while (pos_ < text_.size()) {
+            auto c = static_cast<unsigned char>(text_[pos_]);
+            if (c == '"') {
+                ++pos_;
+                return true;
+            }
+            if (c < 0x20) {
+                return false;  // 控制字符必须转义
+            }
+            if (c == '\\') {
+                if (!parse_escape(out)) {
+                    return false;
+                }
+                continue;
+            }
+            // 未转义的非ASCII字节必须组成合法的UTF-8
+            size_t end = pos_ + 1;
+            while (end < text_.size() && (static_cast<unsigned char>(text_[end]) & 0xC0) == 0x80) {
+                ++end;
+            }
+            auto raw = text_.substr(pos_, end - pos_);
+            if (c >= 0x80 && sanitize(raw) != raw) {
+                return false;
+            }
+            out.append(raw);
+            pos_ = end;
+        }
+        return false;
+    }
+
+    bool parse_escape(std::string& out) {
+        if (++pos_ >= text_.size()) {
+            return false;
+        }
+        char c = text_[pos_++];
+        switch (c) {
+            case '"': out += '"'; return true;
+            case '\\': out += '\\'; return true;
+            case '/': out += '/'; return true;
+            case 'b': out += '\b'; return true;
+            case 'f': out += '\f'; return true;
+            case 'n': out += '\n'; return true;
+            case 'r': out += '\r'; return true;
+            case 't': out += '\t'; return true;
+            case 'u': break;
+            default: return false;
+        }
+        if (pos_ + 4 > text_.size()) {
+            return false;
+        }
+        std::uint32_t code = 0;
+        for (int i = 0; i < 4; ++i) {
+            char h = text_[pos_++];
+            int digit = h >= '0' && h <= '9' ? h - '0' : h >= 'a' && h <= 'f' ? h - 'a' + 10
+                      : h >= 'A' && h <= 'F' ? h - 'A' + 10 : -1;
+            if (digit < 0) {
+                return false;
+            }
+            code = code * 16 + static_cast<std::uint32_t>(digit);
+        }
+        if (code >= 0xD800 && code <= 0xDFFF) {
+            return false;  // 格式化器不会输出代理对
+        }
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        return true;
+    }
+
+    std::string_view text_;
+    size_t pos_ = 0;
+};
+
+} // namespace cpp_log_test
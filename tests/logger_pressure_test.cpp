@@ -0,0 +1,90 @@
+// Logger::pressure不能等待分发：某个sink的写入卡住时，其他线程仍然可以读取负载
+// Logger和StaticLogger的pressure_level按同样的阈值给出建议等级
+#include <cpp_log/log.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "check.hpp"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+// 写入一直阻塞到release，负载固定为0.5
+class BlockingSink : public cpp_log::LogSink {
+public:
+    void write(const cpp_log::LogContext&) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        entered_ = true;
+        changed_.notify_all();
+        changed_.wait(lock, [this] { return released_; });
+    }
+
+    double pressure() const override {
+        return 0.5;
+    }
+
+    void wait_entered() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [this] { return entered_; });
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        released_ = true;
+        changed_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    bool entered_ = false;
+    bool released_ = false;
+};
+
+// 负载由测试直接设置
+class FixedPressureSink : public cpp_log::LogSink {
+public:
+    void write(const cpp_log::LogContext&) override {}
+
+    double pressure() const override {
+        return value;
+    }
+
+    double value = 0.0;
+};
+
+} // namespace
+
+int main() {
+    cpp_log::Logger logger;
+    CPP_LOG_CHECK(logger.pressure() == 0.0);
+
+    auto sink = std::make_shared<BlockingSink>();
+    logger.add_sink(sink);
+    std::thread producer([&] { logger.info(std::source_location::current(), "blocked"); });
+    sink->wait_entered();
+
+    // 分发正持有logger的锁
+    auto reader = std::async(std::launch::async, [&] { return logger.pressure(); });
+    bool ready = reader.wait_for(5s) == std::future_status::ready;
+    sink->release();
+    producer.join();
+    CPP_LOG_CHECK(ready);
+    CPP_LOG_CHECK(reader.get() == 0.5);
+    CPP_LOG_CHECK(logger.pressure_level() == cpp_log::Level::Info);
+
+    logger.clear_sinks();
+    CPP_LOG_CHECK(logger.pressure() == 0.0);
+
+    cpp_log::StaticLogger<FixedPressureSink> static_logger;
+    CPP_LOG_CHECK(static_logger.pressure_level() == static_logger.level());
+    static_logger.sink<0>().value = 0.85;
+    CPP_LOG_CHECK(static_logger.pressure_level() == cpp_log::Level::Warning);
+    static_logger.set_level(cpp_log::Level::Fatal);
+    CPP_LOG_CHECK(static_logger.pressure_level() == cpp_log::Level::Fatal);
+    return 0;
+}
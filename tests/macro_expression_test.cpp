@@ -0,0 +1,48 @@
+// CPP_LOG_*宏是表达式，可以用在条件运算符、逗号表达式等位置；第一个参数只求值一次；
+// 格式字符串可以是constexpr变量。是否启用USDT都一样，macro_expression_usdt_test启用USDT编译同一个文件
+#include <cpp_log/log.hpp>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "check.hpp"
+
+int main() {
+    auto sink = std::make_shared<cpp_log_test::CaptureSink<>>();
+    auto& logger = cpp_log::detail::default_logger();
+    logger.clear_sinks();
+    logger.add_sink(sink);
+
+    // 不带花括号的if/else中作为语句
+    if (sink->size() == 0)
+        CPP_LOG_INFO("first {}", 1);
+    else
+        CPP_LOG_WARN("unexpected");
+    CPP_LOG_CHECK(sink->size() == 1);
+
+    bool failed = true;
+    failed ? CPP_LOG_ERROR("failed {}", 2) : CPP_LOG_INFO("ok");
+    int value = (CPP_LOG_DEBUG("value"), 3);
+    CPP_LOG_CHECK(value == 3);
+    for (int i = 0; i < 2; CPP_LOG_INFO_KV("step", cpp_log::kv("i", i)), ++i) {
+    }
+    CPP_LOG_CHECK(sink->size() == 5);
+
+    // 格式字符串不是字面量而是常量表达式
+    constexpr std::string_view format = "constexpr {}";
+    CPP_LOG_INFO(format, 6);
+    CPP_LOG_CHECK(sink->contains("constexpr 6"));
+
+    // 消息由有副作用的表达式给出，只求值一次
+    int evaluations = 0;
+    auto next_message = [&] { return "message " + std::to_string(++evaluations); };
+    size_t before = sink->size();
+    CPP_LOG_INFO_KV(next_message(), cpp_log::kv("n", 1));
+    CPP_LOG_CHECK(evaluations == 1);
+    CPP_LOG_CHECK(sink->size() == before + 1);
+    CPP_LOG_CHECK(sink->contains("message 1"));
+    CPP_LOG_INFO("single argument");
+    CPP_LOG_CHECK(sink->contains("single argument"));
+
+    logger.clear_sinks();
+    return 0;
+}
@@ -0,0 +1,148 @@
+// 诊断上下文：嵌套作用域和同名覆盖，离开作用域时恢复，%X{key}查不到时为空；
+// 日志记录带着创建时的上下文，异步sink在后台线程上格式化时仍然输出创建时的值；
+// 值保持原本的类型，frame在创建日志记录时才生成
+#include <cpp_log/async_sink.hpp>
+#include <cpp_log/formatter.hpp>
+#include <cpp_log/mdc.hpp>
+#include <cpp_log/record.hpp>
+#include <chrono>
+#include <memory>
+#include <source_location>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "check.hpp"
+
+namespace {
+
+cpp_log::RecordPtr make_record(std::string_view message) {
+    return cpp_log::LogRecord::create(cpp_log::Level::Info, std::source_location::current(), message,
+                                      std::span<const cpp_log::Field>{});
+}
+
+// 用当前线程的上下文按pattern格式化一条日志，去掉结尾的换行
+std::string render(const std::string& pattern) {
+    cpp_log::PatternFormatter formatter(pattern);
+    auto text = formatter.format(make_record("m")->context());
+    return text.substr(0, text.size() - 1);
+}
+
+void nested_scopes() {
+    CPP_LOG_CHECK(render("[%X]") == "[]");
+    {
+        cpp_log::LogScope request{"req", 42};
+        CPP_LOG_CHECK(render("%X") == "req=42");
+        {
+            cpp_log::LogScope user{"user", "alice"};
+            CPP_LOG_CHECK(render("%X") == "req=42 user=alice");
+            CPP_LOG_CHECK(render("%X{user}|%X{req}") == "alice|42");
+            {
+                // 内层同名key覆盖外层，只在内层的位置输出一次
+                cpp_log::LogScope shadow{"req", std::string("inner")};
+                CPP_LOG_CHECK(render("%X") == "user=alice req=inner");
+                CPP_LOG_CHECK(render("%X{req}") == "inner");
+            }
+            CPP_LOG_CHECK(render("%X{req}") == "42");
+        }
+        // 离开内层作用域后恢复
+        CPP_LOG_CHECK(render("%X") == "req=42");
+        CPP_LOG_CHECK(render("[%X{user}]") == "[]");
+        // 未闭合的%X{原样输出
+        CPP_LOG_CHECK(render("%X{req") == "%X{req");
+        // 值中的%不会再被当作占位符
+        cpp_log::LogScope percent{"p", "%m"};
+        CPP_LOG_CHECK(render("%X{p} %m") == "%m m");
+    }
+    CPP_LOG_CHECK(render("[%X]") == "[]");
+    CPP_LOG_CHECK(cpp_log::mdc_snapshot() == nullptr);
+}
+
+// 在写入线程上格式化的一行文本和写入线程
+using Line = std::pair<std::string, std::thread::id>;
+
+std::shared_ptr<cpp_log_test::CaptureSink<Line>> make_target() {
+    auto formatter = std::make_shared<cpp_log::PatternFormatter>("%X{req}|%X|%m");
+    return std::make_shared<cpp_log_test::CaptureSink<Line>>([formatter](const cpp_log::LogContext& context) {
+        auto text = formatter->format(context);
+        return Line{text.substr(0, text.size() - 1), std::this_thread::get_id()};
+    });
+}
+
+void formatted_asynchronously() {
+    auto target = make_target();
+    cpp_log::AsyncSinkAdapter sink(target);
+    // 重排窗口把日志留在队列里，格式化发生在所有作用域都已经退出之后
+    sink.set_reorder_window(std::chrono::hours(1));
+
+    std::thread producer([&sink] {
+        cpp_log::LogScope request{"req", 7};
+        sink.write_record(make_record("outer"));
+        cpp_log::MdcSnapshot snapshot;
+        {
+            cpp_log::LogScope step{"step", "parse"};
+            sink.write_record(make_record("inner"));
+            snapshot = cpp_log::mdc_snapshot();
+        }
+        // 在另一个线程上恢复之前获取的上下文
+        std::thread worker([&sink, snapshot] {
+            CPP_LOG_CHECK(cpp_log::mdc_snapshot() == nullptr);
+            cpp_log::LogScope restored(snapshot);
+            sink.write_record(make_record("worker"));
+        });
+        worker.join();
+    });
+    producer.join();
+    sink.write_record(make_record("none"));
+    CPP_LOG_CHECK(target->size() == 0);
+
+    sink.flush();
+    auto lines = target->entries();
+    CPP_LOG_CHECK(lines.size() == 4);
+    CPP_LOG_CHECK(lines[0].first == "7|req=7|outer");
+    CPP_LOG_CHECK(lines[1].first == "7|req=7 step=parse|inner");
+    CPP_LOG_CHECK(lines[2].first == "7|req=7 step=parse|worker");
+    CPP_LOG_CHECK(lines[3].first == "||none");
+    for (const auto& line : lines) {
+        CPP_LOG_CHECK(line.second != std::this_thread::get_id());
+    }
+}
+
+// 值保持原本的类型，只在输出时转换成文本；没有创建日志记录时不生成frame
+void typed_values() {
+    cpp_log::LogScope count{"count", 42};
+    cpp_log::LogScope ratio{"ratio", 0.5};
+    cpp_log::LogScope ok{"ok", true};
+    cpp_log::LogScope name{"name", std::string_view("bob")};
+
+    auto snapshot = cpp_log::mdc_snapshot();
+    auto* value = cpp_log::mdc_find(snapshot, "count");
+    CPP_LOG_CHECK(value && value->type == cpp_log::FieldType::Int && value->field().as_int() == 42);
+    value = cpp_log::mdc_find(snapshot, "ratio");
+    CPP_LOG_CHECK(value && value->type == cpp_log::FieldType::Double && value->field().as_double() == 0.5);
+    value = cpp_log::mdc_find(snapshot, "name");
+    CPP_LOG_CHECK(value && value->type == cpp_log::FieldType::String && value->text == "bob");
+    CPP_LOG_CHECK(render("%X") == "count=42 ratio=0.5 ok=true name=bob");
+
+    // 同一个作用域内的记录共享同一个frame，压入新的作用域后才有新的frame
+    CPP_LOG_CHECK(make_record("a")->context().mdc == snapshot);
+    {
+        cpp_log::LogScope inner{"inner", 1};
+        cpp_log::LogScope unused{"unused", 2};
+        // 外层的frame已经生成，内层在取快照时一并生成
+        auto nested = cpp_log::mdc_snapshot();
+        CPP_LOG_CHECK(nested->parent->parent == snapshot);
+    }
+    CPP_LOG_CHECK(cpp_log::mdc_snapshot() == snapshot);
+}
+
+} // namespace
+
+int main() {
+    nested_scopes();
+    formatted_asynchronously();
+    typed_values();
+    return 0;
+}
@@ -0,0 +1,22 @@
+// 进程退出时析构的sink注销指标：默认logger先于指标注册表创建，
+// 退出时注册表必须仍然可用，自适应批量的sink才能注销它的瞬时值。
+// 配合-fsanitize=address运行可以发现释放后访问
+#include <cpp_log/log.hpp>
+#include <memory>
+#include "check.hpp"
+
+int main() {
+    // 先创建默认logger，之后才第一次用到指标注册表
+    auto& logger = cpp_log::detail::default_logger();
+
+    auto target = std::make_shared<cpp_log_test::CaptureSink<>>();
+    auto sink = std::make_shared<cpp_log::AsyncSinkAdapter>(target);
+    sink->enable_adaptive_batching({.name = "metrics_exit_test"});
+    logger.add_sink(sink);
+    sink->write(cpp_log::LogContext{});
+    sink->flush();
+    CPP_LOG_CHECK(target->size() == 1);
+
+    // 之后只由默认logger持有，在静态对象析构时才释放
+    return 0;
+}
@@ -0,0 +1,111 @@
+// 为msgpack2json对照测试生成同一批日志的两种格式：MsgpackFormatter的帧和JsonFormatter的JSON Lines
+// 消息、诊断上下文和各种类型的字段都覆盖到，包括需要转义的字符、非法的UTF-8和非有限的浮点数
+// 帧经过FileSink写入文件，长度前缀和内容中的0x0A字节不能被改写
+// 用法：cpp_log_msgpack_records <msgpack文件> <jsonl文件> [条数]
+#include <cpp_log/log.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: %s <msgpack file> <jsonl file> [count]\n", argv[0]);
+        return 2;
+    }
+    size_t count = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 6000;
+    // FileSink以追加方式打开，先清空上一次的输出
+    std::ofstream(argv[1], std::ios::binary | std::ios::trunc);
+    cpp_log::FileSink msgpack_sink(argv[1]);
+    msgpack_sink.set_formatter(std::make_shared<cpp_log::MsgpackFormatter>());
+    std::ofstream json_file(argv[2], std::ios::binary | std::ios::trunc);
+    if (!msgpack_sink.healthy() || !json_file) {
+        std::fprintf(stderr, "cannot open output files\n");
+        return 2;
+    }
+
+    static constexpr const char* messages[] = {
+        "plain message",
+        "quote \" backslash \\ newline \n tab \t",
+        "control \x01\x1f bytes",
+        "utf-8 \xC3\xA9\xE4\xB8\xAD\xF0\x9F\x98\x80",
+        "invalid \xC3 \xFF \xED\xA0\x80 bytes",
+        "",
+    };
+    static constexpr double doubles[] = {
+        0.0, -1.5, 1e300, 3.141592653589793, 1e-7,
+        std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::infinity(),
+    };
+
+    cpp_log::JsonFormatter json;
+    std::string json_out;
+    std::vector<cpp_log::RecordPtr> batch;
+    for (size_t i = 0; i < count; ++i) {
+        std::optional<cpp_log::LogScope> outer;
+        std::optional<cpp_log::LogScope> inner;
+        if (i % 3 != 0) {
+            outer.emplace("request", i);
+        }
+        if (i % 3 == 2) {
+            inner.emplace("user", messages[i % std::size(messages)]);
+        }
+
+        auto message = std::string(messages[i % std::size(messages)]) + " #" + std::to_string(i);
+        auto level = static_cast<cpp_log::Level>(i % (static_cast<size_t>(cpp_log::Level::Fatal) + 1));
+        auto location = std::source_location::current();
+        cpp_log::RecordPtr record;
+        switch (i % 4) {
+            case 0:
+                record = cpp_log::LogRecord::create(level, location, message, std::span<const cpp_log::Field>{});
+                break;
+            case 1: {
+                const cpp_log::Field fields[] = {
+                    cpp_log::kv("int", -static_cast<std::int64_t>(i) * 1000003),
+                    cpp_log::kv("uint", std::numeric_limits<std::uint64_t>::max() - i),
+                    cpp_log::kv("bool", i % 2 == 0),
+                };
+                record = cpp_log::LogRecord::create(level, location, message, fields);
+                break;
+            }
+            case 2: {
+                const cpp_log::Field fields[] = {
+                    cpp_log::kv("double", doubles[i % std::size(doubles)]),
+                    cpp_log::kv("text", messages[(i + 1) % std::size(messages)]),
+                };
+                record = cpp_log::LogRecord::create(level, location, message, fields);
+                break;
+            }
+            default: {
+                const cpp_log::Field fields[] = {
+                    cpp_log::kv("small", static_cast<std::int64_t>(i % 200) - 100),
+                    cpp_log::kv(messages[i % std::size(messages)], i),
+                };
+                record = cpp_log::LogRecord::create(level, location, message, fields);
+                break;
+            }
+        }
+
+        json_out.clear();
+        json.format_to(record->context(), json_out);
+        json_file.write(json_out.data(), static_cast<std::streamsize>(json_out.size()));
+
+        // 单条写入和整批写入两条路径都要经过，两种方式交替，每16条一段，保持日志顺序
+        if (i % 32 < 16) {
+            msgpack_sink.write_record(record);
+        } else {
+            batch.push_back(std::move(record));
+            if (batch.size() == 16) {
+                msgpack_sink.write_batch(batch);
+                batch.clear();
+            }
+        }
+    }
+    msgpack_sink.write_batch(batch);
+    msgpack_sink.flush();
+    return msgpack_sink.healthy() && json_file.good() ? 0 : 1;
+}
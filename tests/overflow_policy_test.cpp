@@ -0,0 +1,201 @@
+// 异步sink的容量和刷新策略：
+// - DropNewest：多个生产者同时提交时pending()不超过容量
+// - DropOldest：输出卡住时不再为每条日志投递任务，保留最新的日志；启用重排窗口时同样受容量限制
+// - Block：生产者等待到有空位，在sink自己的io_context线程上不等待
+// - FlushPolicy：EveryRecord每条写完都刷新，EveryBatch每批刷新一次
+#include <cpp_log/async_sink.hpp>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "check.hpp"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+using Target = cpp_log_test::CaptureSink<>;
+
+void submit(cpp_log::AsyncLogSink& sink, std::string message) {
+    cpp_log::LogContext context{};
+    context.level = cpp_log::Level::Info;
+    context.timestamp = std::chrono::system_clock::now();
+    context.message = std::move(message);
+    sink.write(context);
+}
+
+// 先提交一条日志并等到后台阻塞在写入它上，之后提交的日志都留在队列中
+void stall(cpp_log::AsyncLogSink& sink, Target& target) {
+    target.hold();
+    submit(sink, "0");
+    target.wait_blocked();
+}
+
+void drop_newest() {
+    constexpr int producers = 4;
+    constexpr int per_producer = 1000;
+    auto target = std::make_shared<Target>();
+    cpp_log::AsyncSinkAdapter sink(target);
+    sink.set_capacity(4);
+    sink.set_overflow_policy(cpp_log::OverflowPolicy::DropNewest);
+    stall(sink, *target);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&sink] {
+            for (int i = 0; i < per_producer; ++i) {
+                submit(sink, "n");
+                CPP_LOG_CHECK(sink.pending() <= 4);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    CPP_LOG_CHECK(sink.pending() == 4);
+    CPP_LOG_CHECK(sink.dropped() == producers * per_producer - 3);
+
+    target->release();
+    sink.flush();
+    CPP_LOG_CHECK(target->size() == 4);
+}
+
+void drop_oldest() {
+    auto target = std::make_shared<Target>();
+    cpp_log::AsyncSinkAdapter sink(target);
+    sink.set_capacity(4);
+    sink.set_overflow_policy(cpp_log::OverflowPolicy::DropOldest);
+    stall(sink, *target);
+
+    // 输出卡住时sink占用的日志不超过两倍容量
+    for (int i = 1; i <= 100; ++i) {
+        submit(sink, std::to_string(i));
+        CPP_LOG_CHECK(sink.pending() <= 8);
+    }
+
+    target->release();
+    sink.flush();
+    CPP_LOG_CHECK((target->entries() == std::vector<std::string>{"0", "97", "98", "99", "100"}));
+    CPP_LOG_CHECK(sink.dropped() == 96);
+    CPP_LOG_CHECK(sink.pending() == 0);
+}
+
+// 重排窗口中暂留的日志同样受容量限制
+void reorder_window(cpp_log::OverflowPolicy policy, std::vector<std::string> expected) {
+    auto target = std::make_shared<Target>();
+    cpp_log::AsyncSinkAdapter sink(target);
+    sink.set_capacity(4);
+    sink.set_overflow_policy(policy);
+    sink.set_reorder_window(1h);
+    for (int i = 0; i < 10; ++i) {
+        submit(sink, std::to_string(i));
+        CPP_LOG_CHECK(sink.pending() <= 8);
+    }
+
+    sink.flush();
+    CPP_LOG_CHECK(target->entries() == expected);
+    CPP_LOG_CHECK(sink.dropped() == 6);
+}
+
+void block() {
+    auto target = std::make_shared<Target>();
+    cpp_log::AsyncSinkAdapter sink(target);
+    sink.set_capacity(3);
+    sink.set_overflow_policy(cpp_log::OverflowPolicy::Block);
+    stall(sink, *target);
+    submit(sink, "1");
+    submit(sink, "2");
+
+    std::atomic<bool> done{false};
+    std::thread producer([&] {
+        submit(sink, "3");
+        done = true;
+    });
+    std::this_thread::sleep_for(50ms);
+    CPP_LOG_CHECK(!done);
+    CPP_LOG_CHECK(sink.pending() == 3);
+
+    target->release();
+    producer.join();
+    sink.flush();
+    CPP_LOG_CHECK((target->entries() == std::vector<std::string>{"0", "1", "2", "3"}));
+    CPP_LOG_CHECK(sink.dropped() == 0);
+}
+
+// 在sink所在io_context的线程上提交到已满的队列时不等待：
+// 后台的另一个工作线程被卡住的写入占用，等待会永远等不到
+void block_on_own_thread() {
+    cpp_log::LogBackend::instance().set_thread_count(2);
+    auto target = std::make_shared<Target>();
+    cpp_log::AsyncSinkAdapter sink(target);
+    sink.set_capacity(1);
+    sink.set_overflow_policy(cpp_log::OverflowPolicy::Block);
+    stall(sink, *target);
+
+    std::promise<void> submitted;
+    boost::asio::post(cpp_log::LogBackend::instance().get_io_context(), [&] {
+        submit(sink, "a");
+        submit(sink, "b");
+        submitted.set_value();
+    });
+    CPP_LOG_CHECK(submitted.get_future().wait_for(5s) == std::future_status::ready);
+    CPP_LOG_CHECK(sink.dropped() == 2);
+
+    target->release();
+    sink.flush();
+    CPP_LOG_CHECK((target->entries() == std::vector<std::string>{"0"}));
+    cpp_log::LogBackend::instance().set_thread_count(1);
+}
+
+// 刷新时在收到的日志之间插入"flush"
+class FlushMarkingSink : public Target {
+public:
+    void flush() override {
+        add("flush");
+    }
+};
+
+std::vector<std::string> flushed_sequence(cpp_log::FlushPolicy policy) {
+    auto target = std::make_shared<FlushMarkingSink>();
+    {
+        cpp_log::AsyncSinkAdapter sink(target);
+        sink.set_flush_policy(policy);
+        stall(sink, *target);
+        for (int i = 1; i <= 4; ++i) {
+            submit(sink, std::to_string(i));
+        }
+        target->release();
+    }
+    return target->entries();
+}
+
+void flush_policy() {
+    auto every_record = flushed_sequence(cpp_log::FlushPolicy::EveryRecord);
+    CPP_LOG_CHECK(every_record.size() >= 10);
+    for (size_t i = 0; i < 10; i += 2) {
+        CPP_LOG_CHECK(every_record[i] == std::to_string(i / 2));
+        CPP_LOG_CHECK(every_record[i + 1] == "flush");
+    }
+
+    // 第一条单独成批，其余4条在它写完之前已经入队，作为一批写出后刷新一次
+    auto every_batch = flushed_sequence(cpp_log::FlushPolicy::EveryBatch);
+    CPP_LOG_CHECK(every_batch.size() >= 7);
+    CPP_LOG_CHECK((std::vector<std::string>(every_batch.begin(), every_batch.begin() + 7) ==
+                   std::vector<std::string>{"0", "flush", "1", "2", "3", "4", "flush"}));
+}
+
+} // namespace
+
+int main() {
+    drop_newest();
+    drop_oldest();
+    reorder_window(cpp_log::OverflowPolicy::DropNewest, {"0", "1", "2", "3"});
+    reorder_window(cpp_log::OverflowPolicy::DropOldest, {"6", "7", "8", "9"});
+    block();
+    block_on_own_thread();
+    flush_policy();
+    return 0;
+}
@@ -0,0 +1,108 @@
+// 并行格式化：多个格式化线程同时处理不同批次时，每条日志都要写出且只写一次，
+// 同一生产者线程的日志保持提交顺序；有格式化器和没有格式化器的sink都要检查。
+// 异步sink的输出卡住时写线程不等它，其他sink照常收到全部日志
+#include <cpp_log/log.hpp>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "check.hpp"
+
+namespace {
+
+constexpr int producers = 4;
+
+// 只输出消息文本，格式为"生产者 序号"
+class MessageFormatter : public cpp_log::LogFormatter {
+public:
+    std::string format(const cpp_log::LogContext& context) override {
+        return context.message + "\n";
+    }
+};
+
+// 按收到的顺序记录消息，格式化好的批次去掉结尾的换行
+class CollectingSink : public cpp_log_test::CaptureSink<> {
+public:
+    explicit CollectingSink(bool with_formatter) {
+        if (with_formatter) {
+            formatter_ = std::make_shared<MessageFormatter>();
+        } else {
+            formatter_.reset();
+        }
+    }
+
+    void write_formatted_batch(std::span<const cpp_log::FormattedRecord> records) override {
+        for (const auto& record : records) {
+            CPP_LOG_CHECK(record.text.ends_with('\n'));
+            add(std::string(record.text.substr(0, record.text.size() - 1)));
+        }
+    }
+};
+
+// 每个生产者的序号必须从0开始连续递增，即不丢、不重复、不乱序
+void check_order(const std::vector<std::string>& messages, int per_producer) {
+    std::vector<int> next(producers, 0);
+    for (const auto& message : messages) {
+        auto space = message.find(' ');
+        CPP_LOG_CHECK(space != std::string::npos);
+        int producer = std::atoi(message.substr(0, space).c_str());
+        int index = std::atoi(message.substr(space + 1).c_str());
+        CPP_LOG_CHECK(producer >= 0 && producer < producers);
+        CPP_LOG_CHECK(index == next[producer]);
+        ++next[producer];
+    }
+    for (int count : next) {
+        CPP_LOG_CHECK(count == per_producer);
+    }
+}
+
+void run(size_t formatter_threads, int per_producer) {
+    auto formatted = std::make_shared<CollectingSink>(true);
+    auto unformatted = std::make_shared<CollectingSink>(false);
+    auto async_target = std::make_shared<CollectingSink>(true);
+    auto async_sink = std::make_shared<cpp_log::AsyncSinkAdapter>(async_target);
+    async_target->hold();
+    {
+        cpp_log::ParallelFormatOptions options;
+        options.formatter_threads = formatter_threads;
+        options.batch_size = 64;
+        options.flush_interval = std::chrono::milliseconds(1);
+        cpp_log::ParallelFormatSink sink({formatted, unformatted, async_sink}, options);
+
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&sink, p, per_producer] {
+                for (int i = 0; i < per_producer; ++i) {
+                    cpp_log::LogContext context{};
+                    context.level = cpp_log::Level::Info;
+                    context.timestamp = std::chrono::system_clock::now();
+                    context.message = std::to_string(p) + " " + std::to_string(i);
+                    sink.write(context);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        auto total = static_cast<size_t>(producers * per_producer);
+        CPP_LOG_CHECK(formatted->wait_for_size(total));
+        CPP_LOG_CHECK(unformatted->wait_for_size(total));
+        async_target->release();
+    }
+    // 析构时写完全部批次，异步sink也已刷新
+    check_order(formatted->entries(), per_producer);
+    check_order(unformatted->entries(), per_producer);
+    check_order(async_target->entries(), per_producer);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int per_producer = argc > 1 ? std::atoi(argv[1]) : 20000;
+    for (size_t threads : {1, 2, 4}) {
+        run(threads, per_producer);
+    }
+    return 0;
+}
@@ -0,0 +1,139 @@
+// 高优先级通道：达到优先级的日志越过排队中的普通日志先写出，并且写出后立即刷新，
+// 不等普通通道凑满一批或者被暂留的日志到期
+#include <cpp_log/async_sink.hpp>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "check.hpp"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+// 按顺序记录写入的消息和刷新，gate关闭时第一次写入一直阻塞
+class EventSink : public cpp_log::LogSink {
+public:
+    void write(const cpp_log::LogContext& context) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        entered_ = true;
+        changed_.notify_all();
+        changed_.wait(lock, [this] { return open_; });
+        events_.push_back(context.message);
+    }
+
+    void flush() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        events_.push_back("flush");
+    }
+
+    void close_gate() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        open_ = false;
+    }
+
+    void open_gate() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        open_ = true;
+        changed_.notify_all();
+    }
+
+    // 等到后台线程阻塞在写入中
+    void wait_entered() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [this] { return entered_; });
+    }
+
+    std::vector<std::string> events() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return events_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    bool open_ = true;
+    bool entered_ = false;
+    std::vector<std::string> events_;
+};
+
+void log(cpp_log::LogSink& sink, cpp_log::Level level, const std::string& message) {
+    cpp_log::LogContext context{};
+    context.level = level;
+    context.timestamp = std::chrono::system_clock::now();
+    context.message = message;
+    sink.write(context);
+}
+
+template<typename Predicate>
+bool wait_until(Predicate predicate, std::chrono::milliseconds timeout = 5s) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!predicate()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(1ms);
+    }
+    return true;
+}
+
+size_t count_messages(const std::vector<std::string>& events) {
+    return static_cast<size_t>(std::count_if(events.begin(), events.end(), [](const std::string& event) {
+        return event != "flush";
+    }));
+}
+
+// 后台正在写第一批时提交200条普通日志和1条错误日志，错误日志排在剩下的普通日志之前
+void overtakes_queued_records() {
+    auto target = std::make_shared<EventSink>();
+    cpp_log::AsyncSinkAdapter sink(target);
+    sink.set_batch_size(64);
+
+    target->close_gate();
+    log(sink, cpp_log::Level::Info, "first");
+    target->wait_entered();
+    for (int i = 0; i < 200; ++i) {
+        log(sink, cpp_log::Level::Info, "normal " + std::to_string(i));
+    }
+    log(sink, cpp_log::Level::Error, "error");
+    target->open_gate();
+    CPP_LOG_CHECK(wait_until([&] { return count_messages(target->events()) == 202; }));
+
+    auto events = target->events();
+    auto error = std::find(events.begin(), events.end(), "error");
+    CPP_LOG_CHECK(error != events.end());
+    CPP_LOG_CHECK(std::next(error) != events.end() && *std::next(error) == "flush");
+    // 最多被正在写出的第一批（不超过64条）挡住，其余普通日志都在它之后
+    size_t normals_after = count_messages(std::vector<std::string>(std::next(error), events.end()));
+    CPP_LOG_CHECK(normals_after >= 200 - 64);
+}
+
+// 普通日志被重排窗口暂留时，错误日志立即写出并刷新
+void flushed_without_waiting() {
+    auto target = std::make_shared<EventSink>();
+    cpp_log::AsyncSinkAdapter sink(target);
+    sink.set_reorder_window(std::chrono::hours(1));
+    for (int i = 0; i < 10; ++i) {
+        log(sink, cpp_log::Level::Info, "held " + std::to_string(i));
+    }
+    log(sink, cpp_log::Level::Error, "error");
+    CPP_LOG_CHECK(wait_until([&] { return target->events().size() >= 2; }, 1s));
+
+    auto events = target->events();
+    CPP_LOG_CHECK(events.size() == 2);
+    CPP_LOG_CHECK(events[0] == "error");
+    CPP_LOG_CHECK(events[1] == "flush");
+    CPP_LOG_CHECK(sink.pending() == 10);
+}
+
+} // namespace
+
+int main() {
+    overtakes_queued_records();
+    flushed_without_waiting();
+    return 0;
+}
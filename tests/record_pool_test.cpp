@@ -0,0 +1,271 @@
+// 共享日志记录和RecordPool：
+// - 释放的记录回到缓存池，下一条日志复用它，内容和文本缓存已清空，消息缓冲区的容量保留
+// - 回到缓存池的记录不再持有诊断上下文
+// - 同一条日志只创建一次，所有sink收到同一个记录；共用格式化器时只格式化一次
+// - 多个线程同时创建、跨线程释放记录时内容不会混淆
+// - 格式化消息时抛出异常，取出的记录仍然回到缓存池
+// - 格式化器生成文本时抛出异常，记录的文本缓存之后仍然可用
+// - 文本缓存、去除颜色代码的缓存和调用方的scratch在复用时保留已分配的容量
+#include <cpp_log/log.hpp>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <source_location>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "check.hpp"
+
+// 格式化时总是抛出异常的类型
+struct Throwing {};
+
+template<>
+struct std::formatter<Throwing> : std::formatter<std::string_view> {
+    auto format(const Throwing&, format_context& ctx) const -> decltype(ctx.out()) {
+        throw std::runtime_error("format failed");
+    }
+};
+
+namespace {
+
+cpp_log::RecordPtr make_record(std::string_view message, std::span<const cpp_log::Field> fields = {}) {
+    return cpp_log::LogRecord::create(cpp_log::Level::Info, std::source_location::current(), message, fields);
+}
+
+// 保存收到的记录本身
+class RecordSink : public cpp_log_test::CaptureSink<cpp_log::RecordPtr> {
+public:
+    void write_record(const cpp_log::RecordPtr& record) override {
+        add(record);
+    }
+};
+
+// 记录被格式化的次数
+class CountingFormatter : public cpp_log::LogFormatter {
+public:
+    std::string format(const cpp_log::LogContext& context) override {
+        ++calls;
+        return context.message;
+    }
+
+    int calls = 0;
+};
+
+// 第一次格式化时抛出异常，之后正常返回消息
+class FailingOnceFormatter : public CountingFormatter {
+public:
+    std::string format(const cpp_log::LogContext& context) override {
+        if (!failed) {
+            failed = true;
+            throw std::runtime_error("formatter failed");
+        }
+        return CountingFormatter::format(context);
+    }
+
+    bool failed = false;
+};
+
+// 输出带颜色代码的消息
+class ColorFormatter : public cpp_log::LogFormatter {
+public:
+    std::string format(const cpp_log::LogContext& context) override {
+        std::string out;
+        format_to(context, out);
+        return out;
+    }
+
+    void format_to(const cpp_log::LogContext& context, std::string& out) override {
+        out += cpp_log::color::red;
+        out += context.message;
+        out += cpp_log::color::reset;
+    }
+};
+
+void reuse() {
+    std::string long_message(1000, 'x');
+    cpp_log::Field fields[] = {cpp_log::kv("n", 1)};
+    auto record = make_record(long_message, fields);
+    const cpp_log::LogRecord* address = record.get();
+    CountingFormatter formatter;
+    std::string scratch;
+    CPP_LOG_CHECK(record->text(formatter, scratch) == long_message);
+    record.reset();
+
+    record = make_record("short");
+    CPP_LOG_CHECK(record.get() == address);
+    CPP_LOG_CHECK(record->context().message == "short");
+    CPP_LOG_CHECK(record->context().message.capacity() >= long_message.size());
+    CPP_LOG_CHECK(record->context().fields.empty());
+    CPP_LOG_CHECK(record->text(formatter, scratch) == "short");
+    CPP_LOG_CHECK(formatter.calls == 2);
+}
+
+// 紧接throwing_format执行，缓存池中只有一条记录
+void keeps_capacity() {
+    std::string long_message(1000, 'x');
+    ColorFormatter formatter;
+    std::string scratch;
+    auto record = make_record(long_message);
+    const char* text = record->text(formatter, scratch).data();
+    const char* plain = record->plain_text(formatter, scratch).data();
+    CPP_LOG_CHECK(record->plain_text(formatter, scratch) == long_message);
+    record.reset();
+
+    // 复用的记录把文本生成到原来的缓冲区中
+    record = make_record("short");
+    CPP_LOG_CHECK(record->text(formatter, scratch).data() == text);
+    CPP_LOG_CHECK(record->plain_text(formatter, scratch).data() == plain);
+    CPP_LOG_CHECK(record->plain_text(formatter, scratch) == "short");
+
+    // 文本缓存被其他格式化器占用时生成到scratch中，就地去除颜色代码，scratch保留容量
+    ColorFormatter other;
+    auto in_scratch = record->plain_text(other, scratch);
+    CPP_LOG_CHECK(in_scratch == "short");
+    CPP_LOG_CHECK(in_scratch.data() == scratch.data());
+    const char* scratch_data = scratch.data();
+    CPP_LOG_CHECK(record->text(other, scratch) == "\033[31mshort\033[0m");
+    CPP_LOG_CHECK(scratch.data() == scratch_data);
+}
+
+// 紧接reuse执行，缓存池中只有一条记录
+void throwing_format() {
+    auto record = make_record("first");
+    const cpp_log::LogRecord* address = record.get();
+    record.reset();
+
+    Throwing value;
+    bool thrown = false;
+    try {
+        cpp_log::LogRecord::create(cpp_log::Level::Info, std::source_location::current(),
+                                   "before {} after", std::make_format_args(value));
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    CPP_LOG_CHECK(thrown);
+
+    record = make_record("after");
+    CPP_LOG_CHECK(record.get() == address);
+    CPP_LOG_CHECK(record->context().message == "after");
+}
+
+void throwing_formatter() {
+    auto record = make_record("cached");
+    FailingOnceFormatter formatter;
+    std::string scratch;
+    bool thrown = false;
+    try {
+        record->text(formatter, scratch);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    CPP_LOG_CHECK(thrown);
+
+    // 缓存没有停留在生成中的状态：下一次请求生成并缓存文本，再下一次直接返回缓存
+    auto text = record->text(formatter, scratch);
+    CPP_LOG_CHECK(text == "cached");
+    CPP_LOG_CHECK(text.data() != scratch.data());
+    CPP_LOG_CHECK(record->text(formatter, scratch).data() == text.data());
+    CPP_LOG_CHECK(formatter.calls == 1);
+
+    // 去除颜色代码的文本缓存同样如此
+    auto plain_record = make_record("plain");
+    FailingOnceFormatter plain_formatter;
+    thrown = false;
+    try {
+        plain_record->plain_text(plain_formatter, scratch);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    CPP_LOG_CHECK(thrown);
+    auto plain = plain_record->plain_text(plain_formatter, scratch);
+    CPP_LOG_CHECK(plain == "plain");
+    CPP_LOG_CHECK(plain_record->plain_text(plain_formatter, scratch).data() == plain.data());
+    CPP_LOG_CHECK(plain_formatter.calls == 1);
+}
+
+void releases_mdc() {
+    std::weak_ptr<const cpp_log::MdcFrame> frame;
+    cpp_log::RecordPtr record;
+    {
+        cpp_log::LogScope scope{"req", 42};
+        record = make_record("scoped");
+        frame = record->context().mdc;
+    }
+    CPP_LOG_CHECK(!frame.expired());
+    record.reset();
+    CPP_LOG_CHECK(frame.expired());
+}
+
+void shared_between_sinks() {
+    cpp_log::Logger logger;
+    auto first = std::make_shared<RecordSink>();
+    auto second = std::make_shared<RecordSink>();
+    logger.add_sink(first);
+    logger.add_sink(second);
+    logger.info(std::source_location::current(), "shared {}", 1);
+    logger.clear_sinks();
+
+    CPP_LOG_CHECK(first->size() == 1 && second->size() == 1);
+    auto record = first->entries()[0];
+    CPP_LOG_CHECK(record == second->entries()[0]);
+    CPP_LOG_CHECK(record->context().message == "shared 1");
+
+    // 同一个格式化器的文本缓存在记录中，其他格式化器格式化到scratch
+    CountingFormatter formatter;
+    CountingFormatter other;
+    std::string scratch;
+    auto text = record->text(formatter, scratch);
+    CPP_LOG_CHECK(record->text(formatter, scratch).data() == text.data());
+    CPP_LOG_CHECK(formatter.calls == 1);
+    CPP_LOG_CHECK(record->text(other, scratch) == "shared 1");
+    CPP_LOG_CHECK(record->text(other, scratch).data() == scratch.data());
+    CPP_LOG_CHECK(other.calls == 2);
+}
+
+// 每个线程创建记录交给下一个线程释放，缓存池的槽位在线程之间流动
+void concurrent() {
+    constexpr int threads = 4;
+    constexpr int per_thread = 20000;
+    std::vector<std::mutex> mutexes(threads);
+    std::vector<std::vector<cpp_log::RecordPtr>> handoff(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            for (int i = 0; i < per_thread; ++i) {
+                std::string message = std::to_string(t) + ":" + std::to_string(i);
+                auto record = make_record(message);
+                CPP_LOG_CHECK(record->context().message == message);
+                {
+                    std::lock_guard<std::mutex> lock(mutexes[(t + 1) % threads]);
+                    handoff[(t + 1) % threads].push_back(std::move(record));
+                }
+                std::vector<cpp_log::RecordPtr> received;
+                {
+                    std::lock_guard<std::mutex> lock(mutexes[t]);
+                    received.swap(handoff[t]);
+                }
+                for (const auto& other : received) {
+                    CPP_LOG_CHECK(other->context().message.starts_with(std::to_string((t + threads - 1) % threads) + ":"));
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+} // namespace
+
+int main() {
+    // 缓存池此时为空，第一个用例能确定复用的是哪一条记录
+    reuse();
+    throwing_format();
+    keeps_capacity();
+    throwing_formatter();
+    releases_mdc();
+    shared_between_sinks();
+    concurrent();
+    return 0;
+}
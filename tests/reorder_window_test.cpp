@@ -0,0 +1,116 @@
+// 重排窗口：4个生产者并发写入异步sink，序号在进程内唯一、同一线程内递增；
+// 启用窗口后输出按(时间戳, 序号)有序，乱序的日志不超过late_records()
+#include <cpp_log/async_sink.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <source_location>
+#include <span>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include "check.hpp"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr int producers = 4;
+constexpr int per_producer = 50000;
+
+struct Entry {
+    explicit Entry(const cpp_log::LogContext& context)
+        : timestamp(context.timestamp), sequence(context.sequence), thread_id(context.thread_id) {}
+
+    std::chrono::system_clock::time_point timestamp;
+    std::uint64_t sequence;
+    std::thread::id thread_id;
+};
+
+// 按收到的顺序记录时间戳、序号和线程
+using CollectingSink = cpp_log_test::CaptureSink<Entry>;
+
+// 序号不重复，同一线程内严格递增
+void check_sequences(const std::vector<Entry>& entries) {
+    std::set<std::uint64_t> seen;
+    std::map<std::thread::id, std::uint64_t> last;
+    for (const auto& entry : entries) {
+        CPP_LOG_CHECK(seen.insert(entry.sequence).second);
+    }
+    // 输出可能跨线程乱序，按序号排序后逐线程检查
+    std::vector<Entry> sorted(entries);
+    std::sort(sorted.begin(), sorted.end(), [](const Entry& a, const Entry& b) {
+        return a.sequence < b.sequence;
+    });
+    for (const auto& entry : sorted) {
+        auto [it, inserted] = last.try_emplace(entry.thread_id, entry.sequence);
+        if (!inserted) {
+            CPP_LOG_CHECK(entry.sequence > it->second);
+            it->second = entry.sequence;
+        }
+    }
+    CPP_LOG_CHECK(last.size() == static_cast<std::size_t>(producers));
+}
+
+// 相邻两条日志(时间戳, 序号)倒序的次数
+std::size_t inversions(const std::vector<Entry>& entries) {
+    std::size_t count = 0;
+    for (std::size_t i = 1; i < entries.size(); ++i) {
+        const auto& prev = entries[i - 1];
+        const auto& cur = entries[i];
+        if (std::tie(cur.timestamp, cur.sequence) < std::tie(prev.timestamp, prev.sequence)) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+// 返回输出中的倒序次数
+std::size_t run(std::chrono::nanoseconds window) {
+    auto collector = std::make_shared<CollectingSink>();
+    std::uint64_t late = 0;
+    {
+        cpp_log::AsyncSinkAdapter sink(collector);
+        sink.set_reorder_window(window);
+
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&sink] {
+                for (int i = 0; i < per_producer; ++i) {
+                    sink.write_record(cpp_log::LogRecord::create(
+                        cpp_log::Level::Info, std::source_location::current(), "reorder", std::span<const cpp_log::Field>{}));
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        CPP_LOG_CHECK(collector->wait_for_size(static_cast<std::size_t>(producers * per_producer)));
+        late = sink.late_records();
+    }
+
+    auto entries = collector->entries();
+    CPP_LOG_CHECK(entries.size() == static_cast<std::size_t>(producers * per_producer));
+    check_sequences(entries);
+    auto count = inversions(entries);
+    if (window > std::chrono::nanoseconds::zero()) {
+        // 每条迟到的日志最多造成一次倒序，其余日志已经归并有序
+        CPP_LOG_CHECK(count <= late);
+    }
+    std::cout << "window " << std::chrono::duration_cast<std::chrono::milliseconds>(window).count()
+              << " ms: " << count << " inversions, " << late << " late records\n";
+    return count;
+}
+
+} // namespace
+
+int main() {
+    // 不启用窗口时只输出倒序次数，具体数值取决于线程调度
+    run(std::chrono::nanoseconds::zero());
+    run(20ms);
+    return 0;
+}
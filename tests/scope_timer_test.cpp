@@ -0,0 +1,149 @@
+// 作用域计时器：输出带elapsed_us字段的计时日志，等级未启用或未达到阈值时不输出；
+// TimerStats按周期汇总count/min/avg/max；BasicLogger和StaticLogger都可以使用
+#include <cpp_log/log.hpp>
+#include <cpp_log/static_logger.hpp>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "check.hpp"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+struct Entry {
+    explicit Entry(const cpp_log::LogContext& context)
+        : message(context.message), elapsed(context.elapsed) {
+        for (const auto& field : context.fields) {
+            auto copy = field;
+            copy.key = {};
+            copy.text = {};
+            fields.emplace_back(std::string(field.key), copy);
+        }
+    }
+
+    std::string message;
+    std::chrono::nanoseconds elapsed;
+    std::vector<std::pair<std::string, cpp_log::Field>> fields;  // Field的key和字符串引用记录，只保存数值
+};
+
+using CollectingSink = cpp_log_test::CaptureSink<Entry>;
+
+std::optional<cpp_log::Field> find(const Entry& entry, const std::string& key) {
+    for (const auto& [name, field] : entry.fields) {
+        if (name == key) {
+            return field;
+        }
+    }
+    return std::nullopt;
+}
+
+void elapsed_field() {
+    auto sink = std::make_shared<CollectingSink>();
+    cpp_log::Logger logger;
+    logger.add_sink(sink);
+    {
+        cpp_log::ScopeTimer timer(logger, cpp_log::Level::Info, "work");
+        std::this_thread::sleep_for(5ms);
+    }
+    auto entries = sink->entries();
+    CPP_LOG_CHECK(entries.size() == 1);
+    CPP_LOG_CHECK(entries[0].message == "work");
+    CPP_LOG_CHECK(entries[0].elapsed >= 5ms);
+    auto elapsed_us = find(entries[0], "elapsed_us");
+    CPP_LOG_CHECK(elapsed_us && elapsed_us->type == cpp_log::FieldType::Double);
+    CPP_LOG_CHECK(elapsed_us->as_double() >= 5000.0);
+    // 字段与记录上的耗时一致
+    CPP_LOG_CHECK(elapsed_us->as_double() == static_cast<double>(entries[0].elapsed.count()) / 1000.0);
+
+    // 等级未启用、未达到阈值时都不输出
+    logger.set_level(cpp_log::Level::Warning);
+    { cpp_log::ScopeTimer timer(logger, cpp_log::Level::Info, "disabled"); }
+    logger.set_level(cpp_log::Level::Debug);
+    { cpp_log::ScopeTimer timer(logger, cpp_log::Level::Info, "fast", std::chrono::nanoseconds(1s)); }
+    {
+        cpp_log::ScopeTimer timer(logger, cpp_log::Level::Info, "slow", std::chrono::nanoseconds(1ms));
+        std::this_thread::sleep_for(2ms);
+    }
+    entries = sink->entries();
+    CPP_LOG_CHECK(entries.size() == 2);
+    CPP_LOG_CHECK(entries[1].message == "slow");
+}
+
+void stats_summary() {
+    // 周期内只累计，过了周期的第一次add取得汇总并重新开始
+    cpp_log::TimerStats stats(std::chrono::nanoseconds(1h));
+    auto now = std::chrono::steady_clock::now();
+    CPP_LOG_CHECK(!stats.add(3ms, now));
+    CPP_LOG_CHECK(!stats.add(1ms, now));
+    CPP_LOG_CHECK(!stats.add(2ms, now));
+    auto summary = stats.add(4ms, now + 2h);
+    CPP_LOG_CHECK(summary);
+    CPP_LOG_CHECK(summary->count == 4);
+    CPP_LOG_CHECK(summary->min == 1ms);
+    CPP_LOG_CHECK(summary->max == 4ms);
+    CPP_LOG_CHECK(summary->total == 10ms);
+    CPP_LOG_CHECK(!stats.add(5ms, now + 2h + 1s));
+    summary = stats.add(7ms, now + 4h);
+    CPP_LOG_CHECK(summary && summary->count == 2 && summary->min == 5ms && summary->max == 7ms);
+}
+
+void aggregated_timer() {
+    auto sink = std::make_shared<CollectingSink>();
+    cpp_log::Logger logger;
+    logger.add_sink(sink);
+    cpp_log::TimerStats stats(std::chrono::nanoseconds(50ms));
+    for (int i = 0; i < 3; ++i) {
+        cpp_log::ScopeTimer timer(logger, cpp_log::Level::Info, "parse", stats);
+    }
+    CPP_LOG_CHECK(sink->entries().empty());
+    std::this_thread::sleep_for(60ms);
+    {
+        cpp_log::ScopeTimer timer(logger, cpp_log::Level::Info, "parse", stats);
+        std::this_thread::sleep_for(1ms);
+    }
+    auto entries = sink->entries();
+    CPP_LOG_CHECK(entries.size() == 1);
+    auto count = find(entries[0], "count");
+    auto min_us = find(entries[0], "min_us");
+    auto avg_us = find(entries[0], "avg_us");
+    auto max_us = find(entries[0], "max_us");
+    CPP_LOG_CHECK(count && min_us && avg_us && max_us);
+    CPP_LOG_CHECK(count->as_uint() == 4);
+    CPP_LOG_CHECK(min_us->as_double() <= avg_us->as_double());
+    CPP_LOG_CHECK(avg_us->as_double() <= max_us->as_double());
+    CPP_LOG_CHECK(max_us->as_double() >= 1000.0);
+}
+
+// 转发构造函数只接受与sink个数相同的参数，也不会代替被删除的复制构造函数
+static_assert(!std::is_constructible_v<cpp_log::StaticLogger<CollectingSink>, cpp_log::StaticLogger<CollectingSink>&>);
+static_assert(!std::is_constructible_v<cpp_log::StaticLogger<CollectingSink, CollectingSink>, CollectingSink>);
+static_assert(std::is_constructible_v<cpp_log::StaticLogger<CollectingSink, CollectingSink>,
+                                      CollectingSink::Capture, CollectingSink::Capture>);
+
+void static_logger() {
+    cpp_log::StaticLogger<CollectingSink> logger;
+    {
+        cpp_log::ScopeTimer timer(logger, cpp_log::Level::Info, "static");
+    }
+    logger.sink<0>().set_level(cpp_log::Level::Error);
+    { cpp_log::ScopeTimer timer(logger, cpp_log::Level::Info, "filtered"); }
+    auto entries = logger.sink<0>().entries();
+    CPP_LOG_CHECK(entries.size() == 1);
+    CPP_LOG_CHECK(entries[0].message == "static");
+    CPP_LOG_CHECK(find(entries[0], "elapsed_us"));
+}
+
+} // namespace
+
+int main() {
+    elapsed_field();
+    stats_summary();
+    aggregated_timer();
+    static_logger();
+    return 0;
+}
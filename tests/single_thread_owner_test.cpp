@@ -0,0 +1,112 @@
+// 单线程日志记录器的所有者检查（Debug模式）：
+// - 在一个线程上配置后被另一个线程使用时触发断言
+// - bind_to_current_thread()把所有者交给使用的线程后不再触发
+// 断言会终止进程，每种情况在fork出的子进程中执行，父进程检查退出方式
+#include <cpp_log/log.hpp>
+#include <cpp_log/static_logger.hpp>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <csignal>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include "check.hpp"
+
+namespace {
+
+using CountingSink = cpp_log_test::CaptureSink<>;
+
+// 在子进程中执行body并返回waitpid的状态；预期断言时不输出断言信息
+template<typename Body>
+int run_in_child(Body body, bool quiet) {
+    pid_t pid = ::fork();
+    CPP_LOG_CHECK(pid >= 0);
+    if (pid == 0) {
+        if (quiet) {
+            int null = ::open("/dev/null", O_WRONLY);
+            if (null >= 0) {
+                ::dup2(null, STDERR_FILENO);
+            }
+        }
+        body();
+        ::_exit(0);
+    }
+    int status = 0;
+    CPP_LOG_CHECK(::waitpid(pid, &status, 0) == pid);
+    return status;
+}
+
+bool aborted(int status) {
+    return WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT;
+}
+
+bool exited_cleanly(int status) {
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// 主线程add_sink成为所有者，工作线程写日志
+template<bool Bind>
+void dynamic_logger() {
+    auto sink = std::make_shared<CountingSink>();
+    cpp_log::LoggerST logger;
+    logger.add_sink(sink);
+    std::thread worker([&] {
+        if constexpr (Bind) {
+            logger.bind_to_current_thread();
+        }
+        logger.info(std::source_location::current(), "from worker");
+    });
+    worker.join();
+    if (sink->size() != 1) {
+        ::_exit(3);
+    }
+}
+
+// 主线程写第一条日志成为所有者，工作线程接着写
+template<bool Bind>
+void static_logger() {
+    cpp_log::StaticLoggerST<CountingSink> logger;
+    logger.info(std::source_location::current(), "from main");
+    std::thread worker([&] {
+        if constexpr (Bind) {
+            logger.bind_to_current_thread();
+        }
+        logger.info(std::source_location::current(), "from worker");
+    });
+    worker.join();
+    if (logger.sink<0>().size() != 2) {
+        ::_exit(3);
+    }
+}
+
+// 先在工作线程上配置并写日志，再交回主线程
+void handed_back() {
+    auto sink = std::make_shared<CountingSink>();
+    cpp_log::LoggerST logger;
+    std::thread setup([&] {
+        logger.add_sink(sink);
+        logger.info(std::source_location::current(), "from setup");
+    });
+    setup.join();
+    logger.bind_to_current_thread();
+    logger.info(std::source_location::current(), "from main");
+    if (sink->size() != 2) {
+        ::_exit(3);
+    }
+}
+
+} // namespace
+
+int main() {
+#ifdef NDEBUG
+    std::puts("NDEBUG defined, the owner assertion is compiled out");
+#else
+    CPP_LOG_CHECK(aborted(run_in_child(dynamic_logger<false>, true)));
+    CPP_LOG_CHECK(exited_cleanly(run_in_child(dynamic_logger<true>, false)));
+    CPP_LOG_CHECK(aborted(run_in_child(static_logger<false>, true)));
+    CPP_LOG_CHECK(exited_cleanly(run_in_child(static_logger<true>, false)));
+    CPP_LOG_CHECK(exited_cleanly(run_in_child(handed_back, false)));
+#endif
+    return 0;
+}
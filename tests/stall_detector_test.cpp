@@ -0,0 +1,84 @@
+// 慢速sink检测：输出卡住的sink被报告，名称正确、积压超过阈值，之后每次报告的积压至少翻倍；
+// 正常的sink不被报告。lag()只计算在队列中等待的时间，与日志记录上的时间戳无关。
+// 回调在检测线程上调用时不持有检测器的锁，可以在其中调用snapshot
+#include <cpp_log/async_sink.hpp>
+#include <cpp_log/stall_detector.hpp>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "check.hpp"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+void submit(cpp_log::AsyncLogSink& sink, std::chrono::system_clock::time_point timestamp) {
+    cpp_log::LogContext context{};
+    context.level = cpp_log::Level::Info;
+    context.timestamp = timestamp;
+    sink.write(context);
+}
+
+} // namespace
+
+int main() {
+    auto slow_target = std::make_shared<cpp_log_test::CaptureSink<>>();
+    auto slow = std::make_shared<cpp_log::AsyncSinkAdapter>(cpp_log::dedicated_executor, slow_target);
+    auto fast = std::make_shared<cpp_log::AsyncSinkAdapter>(std::make_shared<cpp_log_test::CaptureSink<>>());
+
+    std::mutex mutex;
+    std::vector<cpp_log::SinkLag> reports;
+    std::vector<size_t> snapshot_sizes;
+    cpp_log::StallDetector detector(50ms, 5ms);
+    detector.set_handler([&](const cpp_log::SinkLag& lag) {
+        auto snapshot = detector.snapshot();
+        std::lock_guard<std::mutex> lock(mutex);
+        reports.push_back(lag);
+        snapshot_sizes.push_back(snapshot.size());
+    });
+    detector.watch("slow", slow);
+    detector.watch("fast", fast);
+
+    // 时间戳在一小时之前的日志刚提交时没有积压
+    slow_target->hold();
+    submit(*slow, std::chrono::system_clock::now() - 1h);
+    slow_target->wait_blocked();
+    CPP_LOG_CHECK(slow->lag() < 1s);
+
+    auto deadline = std::chrono::steady_clock::now() + 30s;
+    while (true) {
+        submit(*fast, std::chrono::system_clock::now());
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (reports.size() >= 3) {
+                break;
+            }
+        }
+        CPP_LOG_CHECK(std::chrono::steady_clock::now() < deadline);
+        std::this_thread::sleep_for(1ms);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < reports.size(); ++i) {
+            CPP_LOG_CHECK(reports[i].name == "slow");
+            CPP_LOG_CHECK(reports[i].pending == 1);
+            CPP_LOG_CHECK(reports[i].lag >= 50ms);
+            CPP_LOG_CHECK(reports[i].lag < 1h);
+            CPP_LOG_CHECK(snapshot_sizes[i] == 2);
+            if (i > 0) {
+                CPP_LOG_CHECK(reports[i].lag >= reports[i - 1].lag * 2);
+            }
+        }
+    }
+
+    // 写出之后不再有积压
+    slow_target->release();
+    slow->flush();
+    CPP_LOG_CHECK(slow->pending() == 0);
+    CPP_LOG_CHECK(slow->lag() == std::chrono::nanoseconds::zero());
+    return 0;
+}
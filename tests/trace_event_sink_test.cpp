@@ -0,0 +1,139 @@
+// Chrome trace-event输出：不调用flush()直接关闭sink，文件仍是合法的JSON数组；
+// 每个线程一条thread_name元数据，计时日志是带dur的完整事件，上下文和字段在args中；
+// 未关闭时按字节数和时间间隔刷新到文件
+#include <cpp_log/mdc.hpp>
+#include <cpp_log/record.hpp>
+#include <cpp_log/trace_event_sink.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <source_location>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "check.hpp"
+#include "json_reader.hpp"
+
+namespace {
+
+using namespace std::chrono_literals;
+using cpp_log_test::JsonReader;
+using cpp_log_test::JsonValue;
+
+std::string read_file(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+cpp_log::RecordPtr make_record(std::string_view message, std::span<const cpp_log::Field> fields = {},
+                               std::chrono::nanoseconds elapsed = std::chrono::nanoseconds::zero()) {
+    return cpp_log::LogRecord::create(cpp_log::Level::Info, std::source_location::current(), message, fields,
+                                      elapsed);
+}
+
+const JsonValue& member(const JsonValue& object, std::string_view key) {
+    static const JsonValue missing;
+    auto value = object.find(key);
+    CPP_LOG_CHECK(value != nullptr);
+    return value ? *value : missing;
+}
+
+void closed_without_flush() {
+    auto path = std::filesystem::temp_directory_path() / "cpp_log_trace_event_test.json";
+    {
+        cpp_log::TraceEventSink sink(path.string());
+        cpp_log::LogScope request{"req", "r\"1"};
+        const cpp_log::Field fields[] = {cpp_log::kv("rows", 3), cpp_log::kv("ok", true)};
+        sink.write(make_record("query", fields)->context());
+        sink.write(make_record("timed", {}, 1500ns)->context());
+        std::thread other([&sink] {
+            sink.write(make_record("from other")->context());
+        });
+        other.join();
+        const cpp_log::RecordPtr batch[] = {make_record("batch 1"), make_record("batch 2")};
+        sink.write_batch(batch);
+    }
+
+    JsonValue root;
+    auto text = read_file(path);
+    CPP_LOG_CHECK(JsonReader(text).parse_document(root));
+    CPP_LOG_CHECK(root.kind == JsonValue::Kind::Array);
+    CPP_LOG_CHECK(root.elements.size() == 7);  // 5条日志，2个线程的元数据
+
+    std::map<std::string, const JsonValue*> events;
+    size_t threads = 0;
+    for (const auto& event : root.elements) {
+        CPP_LOG_CHECK(event.kind == JsonValue::Kind::Object);
+        CPP_LOG_CHECK(member(event, "pid").kind == JsonValue::Kind::Number);
+        CPP_LOG_CHECK(member(event, "tid").kind == JsonValue::Kind::Number);
+        if (member(event, "ph").text == "M") {
+            CPP_LOG_CHECK(member(event, "name").text == "thread_name");
+            CPP_LOG_CHECK(member(event, "tid").text == std::to_string(++threads));
+            continue;
+        }
+        CPP_LOG_CHECK(member(event, "ts").kind == JsonValue::Kind::Number);
+        CPP_LOG_CHECK(member(event, "cat").text == "INFO");
+        events[member(event, "name").text] = &event;
+    }
+    CPP_LOG_CHECK(threads == 2);
+    CPP_LOG_CHECK(events.size() == 5);
+
+    const auto& query = *events["query"];
+    CPP_LOG_CHECK(member(query, "ph").text == "i");
+    CPP_LOG_CHECK(query.find("dur") == nullptr);
+    const auto& args = member(query, "args");
+    CPP_LOG_CHECK(member(args, "req").text == "r\"1");
+    CPP_LOG_CHECK(member(args, "rows").text == "3");
+    CPP_LOG_CHECK(member(args, "ok").text == "true");
+
+    const auto& timed = *events["timed"];
+    CPP_LOG_CHECK(member(timed, "ph").text == "X");
+    CPP_LOG_CHECK(member(timed, "dur").text == "1.500");
+    CPP_LOG_CHECK(member(*events["from other"], "tid").text == "2");
+    CPP_LOG_CHECK(member(*events["from other"], "args").find("req") == nullptr);
+    CPP_LOG_CHECK(member(*events["batch 2"], "tid").text == "1");
+    std::filesystem::remove(path);
+}
+
+// 刷新阈值：超过字节数或时间间隔后，数据在sink关闭之前已经写到文件
+void threshold_flush() {
+    auto path = std::filesystem::temp_directory_path() / "cpp_log_trace_event_flush_test.json";
+    {
+        cpp_log::TraceEventOptions options;
+        options.flush_bytes = 4096;
+        options.flush_interval = std::chrono::hours(1);
+        cpp_log::TraceEventSink sink(path.string(), options);
+        sink.write(make_record("small")->context());
+        CPP_LOG_CHECK(read_file(path).find("small") == std::string::npos);
+        std::string large(4096, 'x');
+        sink.write(make_record(large)->context());
+        auto text = read_file(path);
+        CPP_LOG_CHECK(text.find("small") != std::string::npos);
+        CPP_LOG_CHECK(text.find(large) != std::string::npos);
+    }
+    {
+        cpp_log::TraceEventOptions options;
+        options.flush_interval = 10ms;
+        cpp_log::TraceEventSink sink(path.string(), options);
+        sink.write(make_record("first")->context());
+        std::this_thread::sleep_for(20ms);
+        sink.write(make_record("second")->context());
+        auto text = read_file(path);
+        CPP_LOG_CHECK(text.find("first") != std::string::npos);
+        CPP_LOG_CHECK(text.find("second") != std::string::npos);
+    }
+    std::filesystem::remove(path);
+}
+
+} // namespace
+
+int main() {
+    closed_without_flush();
+    threshold_flush();
+    return 0;
+}
@@ -0,0 +1,228 @@
+// 把MsgpackFormatter输出的日志文件转换成JSON Lines
+// 用法：cpp_log_msgpack2json [文件...]，不指定文件时读取标准输入，结果写到标准输出
+#include <cpp_log/json_formatter.hpp>
+
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace {
+
+// 从一个帧中依次读取MessagePack值
+class Reader {
+public:
+    explicit Reader(std::string_view data) : data_(data) {}
+
+    bool done() const { return pos_ == data_.size(); }
+
+    // 读取一个值并以JSON形式追加到out，top_level_key为顶层map中当前值的key
+    void value(std::string& out, std::string_view top_level_key = {}) {
+        std::uint8_t tag = byte();
+        if (tag <= 0x7f) {
+            integer(out, tag, top_level_key);
+        } else if (tag >= 0xe0) {
+            integer(out, static_cast<std::int8_t>(tag), top_level_key);
+        } else if ((tag & 0xf0) == 0x80) {
+            map(out, tag & 0x0f);
+        } else if ((tag & 0xf0) == 0x90) {
+            array(out, tag & 0x0f);
+        } else if ((tag & 0xe0) == 0xa0) {
+            cpp_log::detail::append_json_string(out, take(tag & 0x1f));
+        } else {
+            switch (tag) {
+                case 0xc0: out += "null"; break;
+                case 0xc2: out += "false"; break;
+                case 0xc3: out += "true"; break;
+                case 0xc4: binary(out, big_endian<std::uint8_t>()); break;
+                case 0xc5: binary(out, big_endian<std::uint16_t>()); break;
+                case 0xc6: binary(out, big_endian<std::uint32_t>()); break;
+                case 0xca: real(out, std::bit_cast<float>(big_endian<std::uint32_t>())); break;
+                case 0xcb: real(out, std::bit_cast<double>(big_endian<std::uint64_t>())); break;
+                case 0xcc: integer(out, big_endian<std::uint8_t>(), top_level_key); break;
+                case 0xcd: integer(out, big_endian<std::uint16_t>(), top_level_key); break;
+                case 0xce: integer(out, big_endian<std::uint32_t>(), top_level_key); break;
+                case 0xcf: integer(out, big_endian<std::uint64_t>(), top_level_key); break;
+                case 0xd0: integer(out, static_cast<std::int8_t>(big_endian<std::uint8_t>()), top_level_key); break;
+                case 0xd1: integer(out, static_cast<std::int16_t>(big_endian<std::uint16_t>()), top_level_key); break;
+                case 0xd2: integer(out, static_cast<std::int32_t>(big_endian<std::uint32_t>()), top_level_key); break;
+                case 0xd3: integer(out, static_cast<std::int64_t>(big_endian<std::uint64_t>()), top_level_key); break;
+                case 0xd9: cpp_log::detail::append_json_string(out, take(big_endian<std::uint8_t>())); break;
+                case 0xda: cpp_log::detail::append_json_string(out, take(big_endian<std::uint16_t>())); break;
+                case 0xdb: cpp_log::detail::append_json_string(out, take(big_endian<std::uint32_t>())); break;
+                case 0xdc: array(out, big_endian<std::uint16_t>()); break;
+                case 0xdd: array(out, big_endian<std::uint32_t>()); break;
+                case 0xde: map(out, big_endian<std::uint16_t>()); break;
+                case 0xdf: map(out, big_endian<std::uint32_t>()); break;
+                default:
+                    throw std::runtime_error(std::format("unsupported MessagePack type 0x{:02x}", tag));
+            }
+        }
+    }
+
+private:
+    std::uint8_t byte() {
+        return static_cast<std::uint8_t>(take(1)[0]);
+    }
+
+    std::string_view take(size_t size) {
+        if (size > data_.size() - pos_) {
+            throw std::runtime_error("truncated MessagePack value");
+        }
+        auto result = data_.substr(pos_, size);
+        pos_ += size;
+        return result;
+    }
+
+    template<typename T>
+    T big_endian() {
+        auto bytes = take(sizeof(T));
+        std::uint64_t value = 0;
+        for (char c : bytes) {
+            value = (value << 8) | static_cast<std::uint8_t>(c);
+        }
+        return static_cast<T>(value);
+    }
+
+    // 顶层的ts是纳秒时间戳，转换成与JsonFormatter相同的UTC时间文本
+    template<typename T>
+    void integer(std::string& out, T value, std::string_view top_level_key) {
+        if (top_level_key == "ts") {
+            auto timestamp = std::chrono::sys_time<std::chrono::nanoseconds>(
+                std::chrono::nanoseconds(static_cast<std::int64_t>(value)));
+            auto seconds = std::chrono::floor<std::chrono::seconds>(timestamp);
+            auto micros = std::chrono::duration_cast<std::chrono::microseconds>(timestamp - seconds).count();
+            std::format_to(std::back_inserter(out), "\"{:%Y-%m-%dT%H:%M:%S}.{:06}Z\"", seconds, micros);
+            return;
+        }
+        std::format_to(std::back_inserter(out), "{}", value);
+    }
+
+    void real(std::string& out, double value) {
+        if (std::isfinite(value)) {
+            std::format_to(std::back_inserter(out), "{}", value);
+        } else {
+            out += "null";
+        }
+    }
+
+    // 二进制数据输出为十六进制字符串
+    void binary(std::string& out, size_t size) {
+        static constexpr char hex[] = "0123456789abcdef";
+        out += '"';
+        for (char c : take(size)) {
+            auto b = static_cast<std::uint8_t>(c);
+            out += hex[b >> 4];
+            out += hex[b & 0xf];
+        }
+        out += '"';
+    }
+
+    void array(std::string& out, size_t size) {
+        out += '[';
+        for (size_t i = 0; i < size; ++i) {
+            if (i > 0) {
+                out += ',';
+            }
+            value(out);
+        }
+        out += ']';
+    }
+
+    void map(std::string& out, size_t size) {
+        bool top_level = depth_++ == 0;
+        out += '{';
+        for (size_t i = 0; i < size; ++i) {
+            if (i > 0) {
+                out += ',';
+            }
+            // JSON的key必须是字符串，其他类型的key转换成文本
+            std::string key;
+            value(key);
+            if (key.empty() || key.front() != '"') {
+                key = '"' + key + '"';
+            }
+            out += key;
+            out += ':';
+            std::string_view name = top_level ? std::string_view(key).substr(1, key.size() - 2) : "";
+            value(out, name);
+        }
+        out += '}';
+        --depth_;
+    }
+
+    std::string_view data_;
+    size_t pos_ = 0;
+    int depth_ = 0;
+};
+
+// 逐帧转换一个输入流，返回是否成功
+bool convert(std::istream& in, const std::string& name) {
+    std::string frame;
+    std::string line;
+    std::uint64_t index = 0;
+    while (true) {
+        unsigned char prefix[4];
+        in.read(reinterpret_cast<char*>(prefix), 4);
+        if (in.gcount() == 0) {
+            return true;
+        }
+        if (in.gcount() != 4) {
+            std::cerr << name << ": truncated length prefix after frame " << index << "\n";
+            return false;
+        }
+        std::uint32_t length = prefix[0] | (prefix[1] << 8) | (prefix[2] << 16) |
+                               (static_cast<std::uint32_t>(prefix[3]) << 24);
+        frame.resize(length);
+        in.read(frame.data(), length);
+        if (static_cast<std::uint32_t>(in.gcount()) != length) {
+            std::cerr << name << ": truncated frame " << index << "\n";
+            return false;
+        }
+
+        line.clear();
+        try {
+            Reader reader(frame);
+            reader.value(line);
+            if (!reader.done()) {
+                throw std::runtime_error("trailing bytes in frame");
+            }
+        } catch (const std::exception& e) {
+            std::cerr << name << ": frame " << index << ": " << e.what() << "\n";
+            return false;
+        }
+        line += '\n';
+        std::cout.write(line.data(), static_cast<std::streamsize>(line.size()));
+        ++index;
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::ios::sync_with_stdio(false);
+
+    if (argc < 2) {
+        return convert(std::cin, "<stdin>") ? 0 : 1;
+    }
+
+    bool ok = true;
+    for (int i = 1; i < argc; ++i) {
+        std::ifstream file(argv[i], std::ios::binary);
+        if (!file) {
+            std::cerr << argv[i] << ": cannot open file\n";
+            ok = false;
+            continue;
+        }
+        ok = convert(file, argv[i]) && ok;
+    }
+    return ok ? 0 : 1;
+}